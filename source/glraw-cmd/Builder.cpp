@@ -1,10 +1,18 @@
 
 #include "Builder.h"
 
+#include <atomic>
 #include <iostream>
 
+#ifdef _WIN32
+#   include <fcntl.h>
+#   include <io.h>
+#endif
+
 #include <QDebug>
 #include <QDir>
+#include <QFile>
+#include <QFileInfo>
 #include <QCoreApplication>
 #include <QCommandLineOption>
 
@@ -13,6 +21,9 @@
 #include <glraw/FileWriter.h>
 #include <glraw/Converter.h>
 #include <glraw/CompressionConverter.h>
+#include <glraw/ConversionCache.h>
+#include <glraw/RawFile.h>
+#include <glraw/RawFileScanner.h>
 #include <glraw/S3TCExtensions.h>
 
 #include "CommandLineOption.h"
@@ -27,10 +38,31 @@ namespace
 
         std::cerr << message.toStdString() << std::endl;
     }
+
+    // options that do not change the written data
+    const QStringList transientOptions = QStringList() << "o" << "output" << "q" << "quiet"
+        << "incremental" << "durability" << "group-size" << "write-budget" << "cache" << "cache-size"
+        << "deduplicate" << "direct-io";
+
+    // options applied by the writer, after conversion
+    const QStringList writerOptions = QStringList() << "r" << "raw" << "n" << "no-suffixes"
+        << "stdout" << "pack" << "no-checksum" << "compression" << "header-version" << "data-alignment";
 }
 
 Builder::Builder()
-:   m_converter(nullptr)
+:   m_verify(false)
+,   m_standardInput(false)
+,   m_sRGB(false)
+,   m_premultiplyAlpha(false)
+,   m_normalMap(false)
+,   m_normalMapKernel(glraw::Canvas::NormalMapKernel::Sobel)
+,   m_normalMapStrength(1.f)
+,   m_normalMapWrapMode(glraw::Canvas::WrapMode::Clamp)
+,   m_normalMapSigned(false)
+,   m_tileSize(0)
+,   m_tileBorder(0)
+,   m_cacheSize(1024)
+,   m_converter(nullptr)
 ,   m_writer(new glraw::FileWriter())
 ,   m_manager(m_writer)
 {
@@ -66,6 +98,136 @@ QList<CommandLineOption> Builder::commandLineOptions()
         &Builder::raw
     });
 
+    options.append({
+        QStringList() << "stdout",
+        "Writes to the standard output, e.g., a pipe.",
+        QString(),
+        &Builder::standardOutput
+    });
+
+    options.append({
+        QStringList() << "stdin",
+        "Converts size-prefixed images from the       " // spaces are required for well formated output
+        "standard input to size-prefixed files on the " // since qt auto-line-breaks after 45 characters.
+        "standard output; sizes are 64 bit LE.",
+        QString(),
+        &Builder::standardInput
+    });
+
+    options.append({
+        QStringList() << "durability",
+        "When files are synced to disk: none, file,   " // spaces are required for well formated output
+        "or group (default: none).",                    // since qt auto-line-breaks after 45 characters.
+        "policy",
+        &Builder::durability
+    });
+
+    options.append({
+        QStringList() << "group-size",
+        "Files per group sync; 0 syncs all files at   " // spaces are required for well formated output
+        "the end (default: 0).",                        // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::groupSize
+    });
+
+    options.append({
+        QStringList() << "write-budget",
+        "Writes on a separate thread while converting," // spaces are required for well formated output
+        "buffering up to the given MiB (default: 0,   " // since qt auto-line-breaks after 45 characters.
+        "writes in between conversions).",
+        "integer",
+        &Builder::writeBudget
+    });
+
+    options.append({
+        QStringList() << "direct-io",
+        "Writes files of at least the given MiB       " // spaces are required for well formated output
+        "bypassing the page cache (default: 0, off).",  // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::directIO
+    });
+
+    options.append({
+        QStringList() << "pack",
+        "Appends all files to one .glpack archive     " // spaces are required for well formated output
+        "instead of writing them separately.",          // since qt auto-line-breaks after 45 characters.
+        "file",
+        &Builder::pack
+    });
+
+    options.append({
+        QStringList() << "no-checksum",
+        "Omits the raw data checksum from the header.",
+        QString(),
+        &Builder::noChecksum
+    });
+
+    options.append({
+        QStringList() << "compression",
+        "Losslessly compresses uncompressed formats:  " // spaces are required for well formated output
+        "none or lz4 (default: none).",                 // since qt auto-line-breaks after 45 characters.
+        "codec",
+        &Builder::compression
+    });
+
+    options.append({
+        QStringList() << "header-version",
+        "Header version: 1 (default) or 2, which      " // spaces are required for well formated output
+        "aligns the raw data offset.",                  // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::headerVersion
+    });
+
+    options.append({
+        QStringList() << "data-alignment",
+        "Raw data alignment of version 2 headers      " // spaces are required for well formated output
+        "in bytes (default: 4096).",                    // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::dataAlignment
+    });
+
+    options.append({
+        QStringList() << "incremental",
+        "Skips sources whose existing output stems    " // spaces are required for well formated output
+        "from equal source content and options.",       // since qt auto-line-breaks after 45 characters.
+        QString(),
+        &Builder::incremental
+    });
+
+    options.append({
+        QStringList() << "cache",
+        "Reuses conversions of equal sources and      " // spaces are required for well formated output
+        "options from the given directory, shared     " // since qt auto-line-breaks after 45 characters.
+        "across runs (see --cache-size).",
+        "directory",
+        &Builder::cache
+    });
+
+    options.append({
+        QStringList() << "cache-size",
+        "Maximum cache size in MiB; least recently    " // spaces are required for well formated output
+        "used entries are evicted (default: 1024).",    // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::cacheSize
+    });
+
+    options.append({
+        QStringList() << "deduplicate",
+        "Hardlinks outputs of sources with equal      " // spaces are required for well formated output
+        "pixels instead of converting them again;     " // since qt auto-line-breaks after 45 characters.
+        "aliases them within --pack archives.",
+        QString(),
+        &Builder::deduplicate
+    });
+
+    options.append({
+        QStringList() << "verify",
+        "Verifies the checksums of the given .glraw   " // spaces are required for well formated output
+        "files and directories instead of converting.", // since qt auto-line-breaks after 45 characters.
+        QString(),
+        &Builder::verify
+    });
+
     options.append({
         QStringList() << "n" << "no-suffixes",
         "Disables file suffixes.",
@@ -181,6 +343,66 @@ QList<CommandLineOption> Builder::commandLineOptions()
         &Builder::uniform
     });
 
+    options.append({
+        QStringList() << "srgb",
+        "Treats the image as sRGB: processing and     " // spaces are required for well formated output
+        "compression happen on linear values.",         // since qt auto-line-breaks after 45 characters.
+        QString(),
+        &Builder::sRGB
+    });
+
+    options.append({
+        QStringList() << "premultiply-alpha",
+        "Multiplies color by alpha on upload.",
+        QString(),
+        &Builder::premultiplyAlpha
+    });
+
+    options.append({
+        QStringList() << "normal-map",
+        "Derives a normal map from the image's        " // spaces are required for well formated output
+        "luminance as height (sobel or scharr).",       // since qt auto-line-breaks after 45 characters.
+        "kernel",
+        &Builder::normalMap
+    });
+
+    options.append({
+        QStringList() << "normal-strength",
+        "Scales the height gradients (default: 1.0).",
+        "decimal",
+        &Builder::normalStrength
+    });
+
+    options.append({
+        QStringList() << "normal-wrap",
+        "Border handling for the normal map           " // spaces are required for well formated output
+        "(clamp, repeat, or mirror; default: clamp).",  // since qt auto-line-breaks after 45 characters.
+        "mode",
+        &Builder::normalWrap
+    });
+
+    options.append({
+        QStringList() << "normal-signed",
+        "Encodes normals in [-1,1] instead of [0,1].",
+        QString(),
+        &Builder::normalSigned
+    });
+
+    options.append({
+        QStringList() << "tile-size",
+        "Stores the raw data in tiles of the given    " // spaces are required for well formated output
+        "edge length in px (virtual textures).",        // since qt auto-line-breaks after 45 characters.
+        "integer",
+        &Builder::tileSize
+    });
+
+    options.append({
+        QStringList() << "tile-border",
+        "Border of each tile in px (default: 0).",
+        "integer",
+        &Builder::tileBorder
+    });
+
     return options;
 }
 
@@ -189,7 +411,7 @@ void Builder::initialize()
     m_parser.setApplicationDescription("Converts Qt supported images to an OpenGL compatible raw format.");
     m_parser.addVersionOption();
 
-    m_parser.addPositionalArgument("sources", "Qt-supported image file(s).");
+    m_parser.addPositionalArgument("sources", "Qt-supported or Radiance (.hdr) image file(s).");
 
     for (auto option : commandLineOptions())
     {
@@ -205,16 +427,18 @@ void Builder::initialize()
                 name,
                 option.configureMethod
             );
+
+            m_canonicalNames.insert(name, option.names.last());
         }
     }
 }
 
-void Builder::process(const QCoreApplication & app)
+int Builder::process(const QCoreApplication & app)
 {
     if (app.arguments().size() == 1)
     {
         showHelp();
-        return;
+        return 0;
     }
     
     m_parser.process(app);
@@ -225,27 +449,60 @@ void Builder::process(const QCoreApplication & app)
     for (auto option : m_parser.optionNames())
     {
         if (!(this->*m_configureMethods.value(option))(option))
-            return;
+            return 0;
+    }
+
+    if (m_verify)
+        return verifySources(m_parser.positionalArguments()) ? 0 : 1;
+
+    // duplicates carry the source hash of their original, so they would never be up to date
+    if (m_manager.deduplicate() && m_manager.incremental())
+    {
+        qDebug() << "--deduplicate cannot be combined with --incremental.";
+        return 0;
     }
 
     if (m_converter == nullptr)
         m_converter = new glraw::Converter();
     
     if (!configureShader())
-        return;
+        return 0;
+
+    configureColorSpace();
+    configureNormalMap();
+    configureTiling();
     
     m_manager.setConverter(m_converter);
+    m_manager.setFingerprint(fingerprint());
+    m_manager.setConversionFingerprint(conversionFingerprint());
+    configureCache();
+
+    if (m_standardInput)
+    {
+        processStandardInput();
+        return 0;
+    }
 
     QStringList sources = m_parser.positionalArguments();
     
     if (sources.size() < 1)
     {
         qDebug() << "No source files passed in.";
-        return;
+        return 0;
     }
     
     for (auto source : sources)
         m_manager.process(source);
+
+    const int failures = m_manager.waitForWrites();
+
+    if (failures > 0)
+        qDebug() << failures << "files could not be written.";
+
+    m_writer->closePack();
+    m_writer->flush();
+
+    return 0;
 }
 
 bool Builder::help(const QString & name)
@@ -364,6 +621,189 @@ bool Builder::raw(const QString & name)
     return true;
 }
 
+bool Builder::standardOutput(const QString & name)
+{
+    m_writer->setStandardOutput(true);
+    return true;
+}
+
+bool Builder::standardInput(const QString & name)
+{
+    m_standardInput = true;
+
+    m_writer->setStandardOutput(true);
+    m_writer->setFramed(true);
+
+    return true;
+}
+
+bool Builder::durability(const QString & name)
+{
+    QString durabilityString = m_parser.value(name);
+
+    if (!Conversions::isDurability(durabilityString))
+    {
+        qDebug() << qPrintable(durabilityString) << "is not a durability policy.";
+        return false;
+    }
+
+    m_writer->setDurability(Conversions::stringToDurability(durabilityString));
+
+    return true;
+}
+
+bool Builder::groupSize(const QString & name)
+{
+    QString sizeString = m_parser.value(name);
+
+    bool ok;
+    int size = sizeString.toInt(&ok);
+    if (!ok || size < 0)
+    {
+        qDebug() << sizeString << "isn't a non-negative int.";
+        return false;
+    }
+
+    m_writer->setGroupSize(size);
+
+    return true;
+}
+
+bool Builder::writeBudget(const QString & name)
+{
+    QString budgetString = m_parser.value(name);
+
+    bool ok;
+    int budget = budgetString.toInt(&ok);
+    if (!ok || budget < 0)
+    {
+        qDebug() << budgetString << "isn't a non-negative int.";
+        return false;
+    }
+
+    m_manager.setWriteBudget(static_cast<size_t>(budget) * 1024 * 1024);
+
+    return true;
+}
+
+bool Builder::directIO(const QString & name)
+{
+    QString thresholdString = m_parser.value(name);
+
+    bool ok;
+    int threshold = thresholdString.toInt(&ok);
+    if (!ok || threshold < 0)
+    {
+        qDebug() << thresholdString << "isn't a non-negative int.";
+        return false;
+    }
+
+    m_writer->setDirectWriteThreshold(static_cast<qint64>(threshold) * 1024 * 1024);
+
+    return true;
+}
+
+bool Builder::pack(const QString & name)
+{
+    return m_writer->openPack(m_parser.value(name));
+}
+
+bool Builder::noChecksum(const QString & name)
+{
+    m_writer->setChecksumEnabled(false);
+    return true;
+}
+
+bool Builder::compression(const QString & name)
+{
+    QString compressionString = m_parser.value(name);
+
+    if (!Conversions::isCompression(compressionString))
+    {
+        qDebug() << qPrintable(compressionString) << "is not a compression.";
+        return false;
+    }
+
+    m_writer->setCompression(Conversions::stringToCompression(compressionString));
+
+    return true;
+}
+
+bool Builder::headerVersion(const QString & name)
+{
+    QString versionString = m_parser.value(name);
+
+    bool ok;
+    int version = versionString.toInt(&ok);
+    if (!ok || version < 1 || version > 2)
+    {
+        qDebug() << versionString << "is not a header version.";
+        return false;
+    }
+
+    m_writer->setHeaderVersion(version);
+
+    return true;
+}
+
+bool Builder::dataAlignment(const QString & name)
+{
+    QString alignmentString = m_parser.value(name);
+
+    bool ok;
+    int alignment = alignmentString.toInt(&ok);
+    if (!ok || alignment < 1)
+    {
+        qDebug() << alignmentString << "isn't a positive int.";
+        return false;
+    }
+
+    m_writer->setDataAlignment(alignment);
+
+    return true;
+}
+
+bool Builder::incremental(const QString & name)
+{
+    m_manager.setIncremental(true);
+    return true;
+}
+
+bool Builder::deduplicate(const QString & name)
+{
+    m_manager.setDeduplicate(true);
+    return true;
+}
+
+bool Builder::cache(const QString & name)
+{
+    m_cacheDirectory = m_parser.value(name);
+    return true;
+}
+
+bool Builder::cacheSize(const QString & name)
+{
+    QString sizeString = m_parser.value(name);
+
+    bool ok;
+    int size = sizeString.toInt(&ok);
+    if (!ok || size < 0)
+    {
+        qDebug() << sizeString << "isn't a non-negative int.";
+        return false;
+    }
+
+    m_cacheSize = size;
+
+    return true;
+}
+
+bool Builder::verify(const QString & name)
+{
+    m_verify = true;
+    return true;
+}
+
 bool Builder::mirrorVertical(const QString & name)
 {
     const QString editorName = "MirrorEditor";
@@ -564,6 +1004,106 @@ bool Builder::uniform(const QString & name)
     return true;
 }
 
+bool Builder::sRGB(const QString & name)
+{
+    m_sRGB = true;
+    return true;
+}
+
+bool Builder::premultiplyAlpha(const QString & name)
+{
+    m_premultiplyAlpha = true;
+    return true;
+}
+
+bool Builder::normalMap(const QString & name)
+{
+    QString kernelString = m_parser.value(name);
+
+    if (!Conversions::isNormalMapKernel(kernelString))
+    {
+        qDebug() << qPrintable(kernelString) << "is not a normal map kernel.";
+        return false;
+    }
+
+    m_normalMap = true;
+    m_normalMapKernel = Conversions::stringToNormalMapKernel(kernelString);
+
+    return true;
+}
+
+bool Builder::normalStrength(const QString & name)
+{
+    QString strengthString = m_parser.value(name);
+
+    bool ok;
+    float strength = strengthString.toFloat(&ok);
+    if (!ok)
+    {
+        qDebug() << strengthString << "isn't a float.";
+        return false;
+    }
+
+    m_normalMapStrength = strength;
+
+    return true;
+}
+
+bool Builder::normalWrap(const QString & name)
+{
+    QString modeString = m_parser.value(name);
+
+    if (!Conversions::isWrapMode(modeString))
+    {
+        qDebug() << qPrintable(modeString) << "is not a wrap mode.";
+        return false;
+    }
+
+    m_normalMapWrapMode = Conversions::stringToWrapMode(modeString);
+
+    return true;
+}
+
+bool Builder::normalSigned(const QString & name)
+{
+    m_normalMapSigned = true;
+    return true;
+}
+
+bool Builder::tileSize(const QString & name)
+{
+    QString sizeString = m_parser.value(name);
+
+    bool ok;
+    int size = sizeString.toInt(&ok);
+    if (!ok || size < 1)
+    {
+        qDebug() << sizeString << "isn't a positive int.";
+        return false;
+    }
+
+    m_tileSize = size;
+
+    return true;
+}
+
+bool Builder::tileBorder(const QString & name)
+{
+    QString borderString = m_parser.value(name);
+
+    bool ok;
+    int border = borderString.toInt(&ok);
+    if (!ok || border < 0)
+    {
+        qDebug() << borderString << "isn't a non-negative int.";
+        return false;
+    }
+
+    m_tileBorder = border;
+
+    return true;
+}
+
 bool Builder::editorExists(const QString & key)
 {
     return m_editors.contains(key);
@@ -593,6 +1133,152 @@ bool Builder::configureShader()
     return true;
 }
 
+void Builder::configureColorSpace()
+{
+    m_converter->setSRGB(m_sRGB);
+    m_converter->setPremultiplyAlpha(m_premultiplyAlpha);
+}
+
+void Builder::configureNormalMap()
+{
+    if (!m_normalMap)
+        return;
+
+    m_converter->setNormalMap(m_normalMapKernel, m_normalMapStrength
+        , m_normalMapWrapMode, m_normalMapSigned);
+}
+
+void Builder::configureTiling()
+{
+    if (m_tileSize == 0)
+        return;
+
+    m_converter->setTiling(m_tileSize, m_tileBorder);
+}
+
+void Builder::configureCache()
+{
+    if (m_cacheDirectory.isEmpty())
+        return;
+
+    m_manager.setCache(new glraw::ConversionCache(m_cacheDirectory, static_cast<qint64>(m_cacheSize) * 1024 * 1024));
+}
+
+QString Builder::fingerprint() const
+{
+    return hashOptions(transientOptions);
+}
+
+QString Builder::conversionFingerprint() const
+{
+    return hashOptions(transientOptions + writerOptions);
+}
+
+QString Builder::hashOptions(const QStringList & ignored) const
+{
+    QByteArray options = QCoreApplication::applicationVersion().toUtf8();
+
+    // in order of appearance, since editors apply in that order
+    for (auto option : m_parser.optionNames())
+    {
+        // short and long spellings of an option yield the same fingerprint
+        const QString name = m_canonicalNames.value(option, option);
+
+        if (ignored.contains(name))
+            continue;
+
+        options.append('\0').append(name.toUtf8());
+
+        // the shader's path does not matter, its content is appended below
+        if (name != "shader")
+            options.append('=').append(m_parser.values(option).join(',').toUtf8());
+    }
+
+    // the shader's content matters, not its path
+    QFile shader(m_shaderSource);
+
+    if (!m_shaderSource.isEmpty() && shader.open(QIODevice::ReadOnly))
+        options.append('\0').append(shader.readAll());
+
+    const quint64 hash = glraw::RawFile::checksum(options.constData(), options.size());
+
+    return QString::number(hash, 16).rightJustified(16, '0');
+}
+
+void Builder::processStandardInput()
+{
+#ifdef _WIN32
+    _setmode(0, _O_BINARY);
+#endif
+
+    QFile input;
+
+    if (!input.open(0, QIODevice::ReadOnly | QIODevice::Unbuffered, QFileDevice::DontCloseHandle))
+    {
+        qDebug() << "Opening the standard input failed.";
+        return;
+    }
+
+    const int count = m_manager.processStream(input);
+    const int failures = m_manager.waitForWrites();
+
+    qDebug() << count << "images converted.";
+
+    if (failures > 0)
+        qDebug() << failures << "frames could not be written.";
+}
+
+bool Builder::verifySources(const QStringList & sources) const
+{
+    std::atomic<int> verified(0);
+    std::atomic<int> failed(0);
+
+    // called concurrently by the scanner's worker threads
+    auto check = [&](const glraw::RawFile & file)
+    {
+        if (file.verify())
+        {
+            ++verified;
+            return;
+        }
+
+        ++failed;
+
+        // e.g., data offsets beyond the end or compressed raw data that fails to decompress
+        const QString message = !file.isValid() ? "is not a valid glraw file."
+            : file.hasStringProperty("checksum") ? "is corrupted." : "has no checksum.";
+        qWarning() << qPrintable(QFile::decodeName(file.filePath().c_str())) << qPrintable(message);
+    };
+
+    // mapped sequential reads let the workers hash at disk bandwidth
+    glraw::RawFileScanner scanner;
+    scanner.setAccess(glraw::RawFile::Access::MapSequential);
+
+    for (auto source : sources)
+    {
+        const QFileInfo sourceInfo(source);
+
+        if (!sourceInfo.exists())
+        {
+            ++failed;
+            qWarning() << qPrintable(source) << "does not exist.";
+            continue;
+        }
+
+        if (sourceInfo.isDir())
+        {
+            scanner.scan(source, check);
+            continue;
+        }
+
+        check(glraw::RawFile(QFile::encodeName(source).toStdString(), true, glraw::RawFile::Access::MapSequential));
+    }
+
+    qDebug() << verified << "files verified," << failed << "failed.";
+
+    return failed == 0;
+}
+
 void Builder::showHelp() const
 {
    qDebug() << qPrintable(m_parser.helpText()) << R"(
@@ -604,7 +1290,13 @@ Formats:        Types:                  Transformation Modes:
   GL_RGB          GL_UNSIGNED_INT         IgnoreAspectRatio
   GL_BGR          GL_INT                  KeepAspectRatio
   GL_RGBA         GL_FLOAT                KeepAspectRatioByExpanding
-  GL_BGRA
+  GL_BGRA         GL_HALF_FLOAT
+
+Packed Types (GL_RGB):                  Packed Types (GL_RGBA, GL_BGRA):
+  GL_UNSIGNED_SHORT_5_6_5                 GL_UNSIGNED_SHORT_4_4_4_4
+  GL_UNSIGNED_INT_10F_11F_11F_REV         GL_UNSIGNED_SHORT_5_5_5_1
+  GL_UNSIGNED_INT_5_9_9_9_REV             GL_UNSIGNED_INT_10_10_10_2
+                                          GL_UNSIGNED_INT_2_10_10_10_REV
 
 Compressed Formats:)";
 
@@ -622,6 +1314,7 @@ R"(  GL_COMPRESSED_RED_RGTC1
 R"(  GL_COMPRESSED_RGBA_BPTC_UNORM
   GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT
   GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT
+  GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM
 )";
 #endif
 
@@ -634,4 +1327,13 @@ R"(  GL_COMPRESSED_RGB_S3TC_DXT1_EXT
 )";
 #endif
 
+#if defined(GLRAW_DXT) && defined(GL_EXT_texture_sRGB)
+    qDebug() <<
+R"(  GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT
+  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT
+  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+)";
+#endif
+
 }
@@ -5,6 +5,7 @@
 #include <QCommandLineParser>
 #include <QScopedPointer>
 
+#include <glraw/Canvas.h>
 #include <glraw/ConvertManager.h>
 
 
@@ -27,7 +28,9 @@ public:
     Builder();
     ~Builder();
 
-    void process(const QCoreApplication & app);
+    /** \return Returns the exit status, which is non-zero if verification failed.
+    */
+    int process(const QCoreApplication & app);
     
 protected:
     static QList<CommandLineOption> commandLineOptions();
@@ -43,6 +46,22 @@ protected:
     bool type(const QString & name);
     bool compressedFormat(const QString & name);
     bool raw(const QString & name);
+    bool noChecksum(const QString & name);
+    bool compression(const QString & name);
+    bool pack(const QString & name);
+    bool standardOutput(const QString & name);
+    bool standardInput(const QString & name);
+    bool durability(const QString & name);
+    bool groupSize(const QString & name);
+    bool writeBudget(const QString & name);
+    bool directIO(const QString & name);
+    bool headerVersion(const QString & name);
+    bool dataAlignment(const QString & name);
+    bool incremental(const QString & name);
+    bool deduplicate(const QString & name);
+    bool cache(const QString & name);
+    bool cacheSize(const QString & name);
+    bool verify(const QString & name);
     bool mirrorVertical(const QString & name);
     bool mirrorHorizontal(const QString & name);
     bool scale(const QString & name);
@@ -54,6 +73,14 @@ protected:
     bool aspectRatioMode(const QString & name);
     bool shader(const QString & name);
     bool uniform(const QString & name);
+    bool sRGB(const QString & name);
+    bool premultiplyAlpha(const QString & name);
+    bool normalMap(const QString & name);
+    bool normalStrength(const QString & name);
+    bool normalWrap(const QString & name);
+    bool normalSigned(const QString & name);
+    bool tileSize(const QString & name);
+    bool tileBorder(const QString & name);
 
 protected:
     bool editorExists(const QString & key);
@@ -63,6 +90,24 @@ protected:
     Editor * editor(const QString & key);
 
     bool configureShader();
+    void configureColorSpace();
+    void configureNormalMap();
+    void configureTiling();
+    void configureCache();
+
+    /** \return Returns a hash of all options that affect the written data.
+    */
+    QString fingerprint() const;
+
+    /** \return Returns a hash of the options that affect the converted data, i.e.,
+                excluding those applied by the writer.
+    */
+    QString conversionFingerprint() const;
+
+    QString hashOptions(const QStringList & ignored) const;
+
+    bool verifySources(const QStringList & sources) const;
+    void processStandardInput();
     
     void showHelp() const;
 
@@ -70,9 +115,30 @@ protected:
     QCommandLineParser m_parser;
     QMap<QString, ConfigureMethod> m_configureMethods;
 
+    // long name of each option by any of its names, e.g., "format" by "f"
+    QMap<QString, QString> m_canonicalNames;
+
     QString m_shaderSource;
     QStringList m_uniformList;
 
+    bool m_verify;
+    bool m_standardInput;
+
+    bool m_sRGB;
+    bool m_premultiplyAlpha;
+
+    bool m_normalMap;
+    glraw::Canvas::NormalMapKernel m_normalMapKernel;
+    float m_normalMapStrength;
+    glraw::Canvas::WrapMode m_normalMapWrapMode;
+    bool m_normalMapSigned;
+
+    int m_tileSize;
+    int m_tileBorder;
+
+    QString m_cacheDirectory;
+    int m_cacheSize;
+
     QMap<QString, glraw::ImageEditorInterface *> m_editors;
     glraw::AbstractConverter * m_converter;
     glraw::FileWriter * m_writer;
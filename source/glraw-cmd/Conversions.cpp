@@ -34,6 +34,14 @@ QMap<QString, GLenum> types()
     types["GL_UNSIGNED_INT"] = GL_UNSIGNED_INT;
     types["GL_INT"] = GL_INT;
     types["GL_FLOAT"] = GL_FLOAT;
+    types["GL_HALF_FLOAT"] = GL_HALF_FLOAT;
+    types["GL_UNSIGNED_SHORT_5_6_5"] = GL_UNSIGNED_SHORT_5_6_5;
+    types["GL_UNSIGNED_SHORT_4_4_4_4"] = GL_UNSIGNED_SHORT_4_4_4_4;
+    types["GL_UNSIGNED_SHORT_5_5_5_1"] = GL_UNSIGNED_SHORT_5_5_5_1;
+    types["GL_UNSIGNED_INT_10_10_10_2"] = GL_UNSIGNED_INT_10_10_10_2;
+    types["GL_UNSIGNED_INT_2_10_10_10_REV"] = GL_UNSIGNED_INT_2_10_10_10_REV;
+    types["GL_UNSIGNED_INT_10F_11F_11F_REV"] = GL_UNSIGNED_INT_10F_11F_11F_REV;
+    types["GL_UNSIGNED_INT_5_9_9_9_REV"] = GL_UNSIGNED_INT_5_9_9_9_REV;
 
     return types;
 }
@@ -52,6 +60,7 @@ QMap<QString, GLint> compressedFormats()
     formats["GL_COMPRESSED_RGBA_BPTC_UNORM"] = GL_COMPRESSED_RGBA_BPTC_UNORM_ARB;
     formats["GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT"] = GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB;
     formats["GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT"] = GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB;
+    formats["GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM"] = GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB;
 #endif
 #ifdef GLRAW_DXT // special treatment here - see S3TCExtensions.h
     formats["GL_COMPRESSED_RGB_S3TC_DXT1_EXT"] =  GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
@@ -59,6 +68,12 @@ QMap<QString, GLint> compressedFormats()
     formats["GL_COMPRESSED_RGBA_S3TC_DXT3_EXT"] =  GL_COMPRESSED_RGBA_S3TC_DXT3_EXT;
     formats["GL_COMPRESSED_RGBA_S3TC_DXT5_EXT"] =  GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
 #endif
+#if defined(GLRAW_DXT) && defined(GL_EXT_texture_sRGB)
+    formats["GL_COMPRESSED_SRGB_S3TC_DXT1_EXT"] =  GL_COMPRESSED_SRGB_S3TC_DXT1_EXT;
+    formats["GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT"] =  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT;
+    formats["GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT"] =  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT;
+    formats["GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT"] =  GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT;
+#endif
     
     return formats;
 }
@@ -82,6 +97,44 @@ QMap<QString, Qt::AspectRatioMode> aspectRatioModes()
     return modes;
 }
 
+QMap<QString, glraw::Canvas::NormalMapKernel> normalMapKernels()
+{
+    QMap<QString, glraw::Canvas::NormalMapKernel> kernels;
+    kernels["sobel"] = glraw::Canvas::NormalMapKernel::Sobel;
+    kernels["scharr"] = glraw::Canvas::NormalMapKernel::Scharr;
+
+    return kernels;
+}
+
+QMap<QString, glraw::Canvas::WrapMode> wrapModes()
+{
+    QMap<QString, glraw::Canvas::WrapMode> modes;
+    modes["clamp"] = glraw::Canvas::WrapMode::Clamp;
+    modes["repeat"] = glraw::Canvas::WrapMode::Repeat;
+    modes["mirror"] = glraw::Canvas::WrapMode::Mirror;
+
+    return modes;
+}
+
+QMap<QString, glraw::FileWriter::Durability> durabilities()
+{
+    QMap<QString, glraw::FileWriter::Durability> durabilities;
+    durabilities["none"] = glraw::FileWriter::Durability::None;
+    durabilities["file"] = glraw::FileWriter::Durability::File;
+    durabilities["group"] = glraw::FileWriter::Durability::Group;
+
+    return durabilities;
+}
+
+QMap<QString, glraw::FileWriter::Compression> compressions()
+{
+    QMap<QString, glraw::FileWriter::Compression> compressions;
+    compressions["none"] = glraw::FileWriter::Compression::None;
+    compressions["lz4"] = glraw::FileWriter::Compression::LZ4;
+
+    return compressions;
+}
+
 } // namespace
 
 namespace Conversions
@@ -157,4 +210,60 @@ Qt::AspectRatioMode stringToAspectRatioMode(const QString & string)
     return m.value(string);
 }
 
+bool isNormalMapKernel(const QString & string)
+{
+    static auto k = normalMapKernels();
+
+    return k.contains(string);
+}
+
+glraw::Canvas::NormalMapKernel stringToNormalMapKernel(const QString & string)
+{
+    static auto k = normalMapKernels();
+
+    return k.value(string);
+}
+
+bool isWrapMode(const QString & string)
+{
+    static auto m = wrapModes();
+
+    return m.contains(string);
+}
+
+glraw::Canvas::WrapMode stringToWrapMode(const QString & string)
+{
+    static auto m = wrapModes();
+
+    return m.value(string);
+}
+
+bool isDurability(const QString & string)
+{
+    static auto d = durabilities();
+
+    return d.contains(string);
+}
+
+glraw::FileWriter::Durability stringToDurability(const QString & string)
+{
+    static auto d = durabilities();
+
+    return d.value(string);
+}
+
+bool isCompression(const QString & string)
+{
+    static auto c = compressions();
+
+    return c.contains(string);
+}
+
+glraw::FileWriter::Compression stringToCompression(const QString & string)
+{
+    static auto c = compressions();
+
+    return c.value(string);
+}
+
 } // namespace Conversions
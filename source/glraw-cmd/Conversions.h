@@ -4,6 +4,9 @@
 #include <Qt>
 #include <QtGui/qopengl.h>
 
+#include <glraw/Canvas.h>
+#include <glraw/FileWriter.h>
+
 class QString;
 
 namespace Conversions
@@ -22,4 +25,16 @@ namespace Conversions
 
     bool isAspectRatioMode(const QString & string);
     Qt::AspectRatioMode stringToAspectRatioMode(const QString & string);
+
+    bool isNormalMapKernel(const QString & string);
+    glraw::Canvas::NormalMapKernel stringToNormalMapKernel(const QString & string);
+
+    bool isWrapMode(const QString & string);
+    glraw::Canvas::WrapMode stringToWrapMode(const QString & string);
+
+    bool isDurability(const QString & string);
+    glraw::FileWriter::Durability stringToDurability(const QString & string);
+
+    bool isCompression(const QString & string);
+    glraw::FileWriter::Compression stringToCompression(const QString & string);
 }
@@ -7,7 +7,5 @@ int main(int argc, char * argv[])
     Application app(argc, argv);
     
     Builder builder;
-    builder.process(app);
-
-    return 0;
+    return builder.process(app);
 }
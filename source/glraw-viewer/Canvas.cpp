@@ -282,7 +282,7 @@ bool Canvas::loadGLRawImage(const QString & fileName)
 	if (fi.suffix() != "glraw")
 		return false;
 
-	glraw::RawFile rawFile(fileName.toStdString());
+	glraw::RawFile rawFile(fileName.toStdString(), true, glraw::RawFile::Access::MapSequential);
 
 	if (!rawFile.isValid())
 		return false;
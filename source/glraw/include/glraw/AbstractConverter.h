@@ -16,25 +16,87 @@ namespace glraw
 {
 
 class AssetInformation;
+class HDRImage;
 
 class GLRAW_API AbstractConverter
 {
+public:
+    using DataHandler = Canvas::DataHandler;
+
 public:
     AbstractConverter();
     virtual ~AbstractConverter();
 
-    virtual QByteArray convert(QImage & image, AssetInformation & info) = 0;
+    QByteArray convert(QImage & image, AssetInformation & info);
+    QByteArray convert(const HDRImage & image, AssetInformation & info);
+
+    /** As convert(), but passes the converted data to handler while it still resides in
+        a mapped pixel buffer, which spares copying it to client memory. info is complete
+        by then; imageData is valid during the call only.
+        \return Returns false if the conversion failed or handler returned false.
+    */
+    bool convert(QImage & image, AssetInformation & info, const DataHandler & handler);
+    bool convert(const HDRImage & image, AssetInformation & info, const DataHandler & handler);
 
     bool hasFragmentShader() const;
     bool setFragmentShader(const QString & sourcePath);
 
     bool setUniform(const QString & assignment);
 
+    void setSRGB(bool enabled);
+    void setPremultiplyAlpha(bool enabled);
+
+    bool hasNormalMap() const;
+    void setNormalMap(
+        Canvas::NormalMapKernel kernel
+    ,   float strength
+    ,   Canvas::WrapMode wrapMode
+    ,   bool signedOutput);
+
+    bool hasTiling() const;
+
+    /** Stores the raw data as tiles of tileSize x tileSize pixels, each surrounded by
+        border pixels copied from its neighbours (clamped at the image edges) and stored
+        contiguously, so that a single read fetches one tile. Compressed data is tiled
+        in blocks, which requires multiples of 4 for both sizes.
+        \param tileSize Edge length in pixels; 0 disables tiling.
+    */
+    void setTiling(int tileSize, int border);
+
+protected:
+    /** Applies the fragment shader and normal map pass to the loaded texture.
+    */
+    bool processTexture();
+
+    /** Reads back the loaded and processed texture in the target format and passes it to handler.
+    */
+    virtual bool convertTexture(AssetInformation & info, const DataHandler & handler) = 0;
+
+    /** \return Returns handler, preceded by arrangeTiles() if tiling is enabled.
+    */
+    DataHandler tilingHandler(AssetInformation & info, const DataHandler & handler) const;
+
+    /** Rearranges row-major raw data into tiles and indexes them by the properties
+        tileSize, tileBorder, tileColumns, tileRows and tileBytes: tile (column, row)
+        starts at (row * tileColumns + column) * tileBytes, with rows in the order
+        of the raw data.
+    */
+    QByteArray arrangeTiles(const QByteArray & imageData, AssetInformation & info) const;
+
 protected:
     Canvas m_canvas;
     QString m_fragmentShader;
 
     QMap<QString, QString> m_uniforms;
+
+    bool m_normalMap;
+    Canvas::NormalMapKernel m_normalMapKernel;
+    float m_normalMapStrength;
+    Canvas::WrapMode m_normalMapWrapMode;
+    bool m_normalMapSigned;
+
+    int m_tileSize;
+    int m_tileBorder;
 };
 
 } // namespace glraw
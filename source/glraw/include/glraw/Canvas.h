@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include <QWindow>
 #include <QOpenGLFunctions_3_2_Core>
 
@@ -14,31 +16,116 @@ class QOpenGLFunctions_3_2_Core;
 namespace glraw
 {
 
+class HDRImage;
+
 class GLRAW_API Canvas : public QWindow
 {
+public:
+    enum class NormalMapKernel
+    {
+        Sobel,
+        Scharr
+    };
+
+    enum class WrapMode
+    {
+        Clamp,
+        Repeat,
+        Mirror
+    };
+
+    /** Receives read back data, which may borrow a mapped pixel buffer and
+        is valid during the call only.
+    */
+    using DataHandler = std::function<bool(const QByteArray & imageData)>;
+
 public:
     Canvas();
     virtual ~Canvas();
 
     void initializeGL();
 
+    /** Uploads the image as GL_RGBA8 (or GL_SRGB8_ALPHA8). Images with more than
+        8 bit per channel (requires Qt 5.12) are uploaded as GL_RGBA16 instead.
+    */
     void loadTextureFromImage(const QImage & image);
+    void loadTextureFromImage(const HDRImage & image);
     QByteArray imageFromTexture(GLenum format, GLenum type);
     QByteArray compressedImageFromTexture(GLenum compressedInternalFormat);
 
+    /** Read back into a pixel buffer, which handler reads while it is mapped, 
+        so that no copy in client memory is needed, e.g., for writing it to disk.
+        \return Returns false if reading back failed or handler returned false.
+    */
+    bool imageFromTexture(GLenum format, GLenum type, const DataHandler & handler);
+    bool compressedImageFromTexture(GLenum compressedInternalFormat, const DataHandler & handler);
+
     bool process(
         const QString & fragmentShader
     ,   const QMap<QString, QString> & uniforms);
 
+    /** Replaces the loaded texture by a tangent space normal map derived from its 
+        luminance (interpreted as height). The normal is encoded as (x, y, z) in 
+        (r, g, b), so reading back GL_RG or compressing to RGTC2 keeps x and y only.
+        With sRGB enabled, heights are taken from linear values and the normal map is
+        read back without sRGB encoding.
+        \param signedOutput Stores the normal in [-1, 1] instead of [0, 1], intended
+                            for GL_BYTE or signed RGTC2 output.
+    */
+    bool generateNormalMap(
+        NormalMapKernel kernel
+    ,   float strength
+    ,   WrapMode wrapMode
+    ,   bool signedOutput);
+
     bool textureLoaded() const;
 
+    /** When enabled, images are uploaded as GL_SRGB8_ALPHA8. Processing then 
+        happens on linear values, which are encoded to sRGB again before readback 
+        or compression.
+    */
+    bool sRGB() const;
+    void setSRGB(bool enabled);
+
+    /** When enabled, color is multiplied by alpha on upload (in linear space if sRGB is enabled).
+    */
+    bool premultiplyAlpha() const;
+    void setPremultiplyAlpha(bool enabled);
+
 protected:
+    bool process(
+        const QString & fragmentShader
+    ,   const QMap<QString, QString> & uniforms
+    ,   GLenum internalFormat);
+
+    /** Encodes the linear texture to sRGB without quantizing it below the readback type.
+    */
+    void encodeSRGB(GLenum type);
+
+    /** Maps the bound GL_PIXEL_PACK_BUFFER for the duration of handler.
+        Fails if size cannot be held by a QByteArray.
+    */
+    bool mapPixelBuffer(GLsizeiptr size, const DataHandler & handler);
+
+    static bool isHighBitDepth(const QImage & image);
+    static QImage convertToHighBitDepthGLFormat(const QImage & image);
+
     static int byteSizeOf(GLenum type);
     static int numberOfElementsFor(GLenum format);
+
+    /** \return Returns the size of a pixel in bytes or -1 if a packed type does not fit the format.
+    */
+    static int byteSizeOfPixel(GLenum format, GLenum type);
     
     QOpenGLContext m_context;
     GLuint m_texture;   
 
+    bool m_sRGB;
+    bool m_premultiplyAlpha;
+
+    // true while the texture holds linear values decoded from sRGB
+    bool m_sRGBDecoded;
+
     // using gl as a memeber instead of inheritance 
     // probably resolves an deinitialization issue.
     QOpenGLFunctions_3_2_Core * m_gl;
@@ -22,10 +22,11 @@ public:
     CompressionConverter();
     virtual ~CompressionConverter();
 
-    virtual QByteArray convert(QImage & image, AssetInformation & info);
-
     void setCompressedFormat(GLint compressedFormat);
 
+protected:
+    virtual bool convertTexture(AssetInformation & info, const DataHandler & handler);
+
 protected:
     GLint m_compressedFormat;
 
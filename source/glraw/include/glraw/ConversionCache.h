@@ -0,0 +1,58 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+
+#include <glraw/glraw_api.h>
+
+
+namespace glraw
+{
+
+class AssetInformation;
+
+/** @brief
+ * Content-addressed store of converted images, shared across runs and processes.
+ *
+ * Entries hold the converted data, its checksum and its properties under a key that
+ * identifies source content and conversion settings (see ConvertManager::setCache()).
+ * Entries are written to a temporary file and renamed over existing ones, so several
+ * processes, e.g., on different machines sharing the directory, may use one cache
+ * concurrently. Once the entries exceed the maximum size, the least recently used
+ * ones are removed, as told by their file times.
+ */
+class GLRAW_API ConversionCache
+{
+public:
+    /** \param maximumSize Size in bytes the entries are evicted down to.
+    */
+    ConversionCache(const QString & directory, qint64 maximumSize);
+    ~ConversionCache();
+
+    const QString & directory() const;
+    qint64 maximumSize() const;
+
+    /** Marks a found entry as recently used. Entries failing their checksum are removed.
+        \return Returns false if there is no valid entry for key.
+    */
+    bool load(const QString & key, QByteArray & imageData, AssetInformation & info);
+
+    bool store(const QString & key, const QByteArray & imageData, const AssetInformation & info);
+
+    /** Removes the least recently used entries until the remaining ones fit into the maximum size.
+        Temporary files count against it as well; those left by crashed runs are removed.
+    */
+    void evict();
+
+protected:
+    QString entryPath(const QString & key) const;
+
+protected:
+    QString m_directory;
+    qint64 m_maximumSize;
+
+    // size of all entries when last counted plus the size stored since
+    qint64 m_size;
+};
+
+} // namespace glraw
@@ -2,17 +2,27 @@
 
 #include <glraw/glraw_api.h>
 
+#include <QByteArray>
+#include <QHash>
 #include <QString>
 #include <QScopedPointer>
 #include <QLinkedList>
 
+#include <glraw/AbstractConverter.h>
+#include <glraw/AssetInformation.h>
+
+class QImage;
+class QIODevice;
+
 
 namespace glraw
 {
 
 class ImageEditorInterface;
 class FileWriter;
-class AbstractConverter;
+class ConversionCache;
+class HDRImage;
+class WriteQueue;
 
 class GLRAW_API ConvertManager
 {
@@ -25,17 +35,112 @@ public:
 
     bool process(const QString & sourcePath);
 
+    /** Converts an encoded image held in memory, e.g., received from another process.
+        \param name Used in place of the source path to name the written file.
+    */
+    bool processData(const QByteArray & encodedImage, const QString & name);
+
+    /** Converts a stream of frames, each an encoded image preceded by its size as
+        64 bit little endian integer, until the input ends. The writer should be framed
+        (see FileWriter::setFramed()); an empty frame is written for each image that
+        cannot be converted, so that outputs correspond to inputs one to one.
+        \return Returns the number of converted images.
+    */
+    int processStream(QIODevice & input);
+
     void appendImageEditor(ImageEditorInterface * editor);
     
     void setWriter(FileWriter * writer);
     void setConverter(AbstractConverter * converter);
 
+    /** Identifies the settings of converter and editors, e.g., a hash of all options.
+        If set, written headers store it as fingerprint property, next to the hash of
+        the source file as sourceHash property.
+    */
+    void setFingerprint(const QString & fingerprint);
+    const QString & fingerprint() const;
+
+    /** Identifies the settings of converter and editors only, excluding those of the
+        writer, e.g., compression or header version, which apply on writing. Keys cache
+        entries, so that runs differing in writer settings share them.
+        If empty, fingerprint() is used instead.
+    */
+    void setConversionFingerprint(const QString & fingerprint);
+    const QString & conversionFingerprint() const;
+
+    /** If enabled, process() skips sources whose output already holds the current
+        fingerprint and source hash, without decoding or converting them.
+    */
+    void setIncremental(bool b);
+    bool incremental() const;
+
+    /** If set, process() takes converted images from the cache instead of decoding and
+        converting their sources, and stores them there after conversion. Entries are
+        keyed by source hash and conversion fingerprint, so a fingerprint is required.
+    */
+    void setCache(ConversionCache * cache);
+
+    /** If enabled, process() hashes the decoded pixels of each source. Sources whose
+        pixels were converted before with the same fingerprint are not converted again,
+        but written as duplicate of the earlier output (see FileWriter::writeDuplicate()).
+        Does not apply to the standard output, nor in incremental mode: duplicates share
+        the header of the original, whose sourceHash would never match their own source.
+    */
+    void setDeduplicate(bool b);
+    bool deduplicate() const;
+
+    /** Moves writing onto a dedicated thread, so conversion overlaps with disk I/O.
+        Converting blocks while the converted data awaiting writing exceeds bytes.
+        \param bytes 0 writes on the calling thread (default).
+    */
+    void setWriteBudget(size_t bytes);
+    size_t writeBudget() const;
+
+    /** Blocks until all pending writes are completed; call it before flushing the writer.
+        \return Returns the number of writes that failed since the last call.
+    */
+    int waitForWrites();
+
+protected:
+    /** Applies the editors and converts image, passing the converted data to handler.
+    */
+    bool convertImage(QImage & image, AssetInformation & info, const AbstractConverter::DataHandler & handler);
+    bool convertHDRImage(const HDRImage & image, AssetInformation & info, const AbstractConverter::DataHandler & handler);
+
+    /** Writes directly from imageData, even if it borrows a mapped pixel buffer, unless
+        writes are queued (see setWriteBudget()).
+        \return Returns false if writing failed, or if queued, always true.
+    */
+    bool write(const QByteArray & imageData, const QString & name, AssetInformation & info);
+    bool writeEmptyFrame();
+    bool writeDuplicate(const QString & sourcePath, const QString & originalSourcePath, const AssetInformation & info);
+
 protected:
     QLinkedList<ImageEditorInterface *> m_editors;
     
     QScopedPointer<FileWriter> m_writer;
     QScopedPointer<AbstractConverter> m_converter;
 
+    QScopedPointer<ConversionCache> m_cache;
+
+    QString m_fingerprint;
+    QString m_conversionFingerprint;
+    bool m_incremental;
+
+    struct Original
+    {
+        QString sourcePath;
+        AssetInformation info;
+    };
+
+    bool m_deduplicate;
+
+    // converted sources by pixel hash and fingerprint
+    QHash<QString, Original> m_originals;
+
+    // declared last, so pending writes complete before the writer is destroyed
+    QScopedPointer<WriteQueue> m_writeQueue;
+
 };
 
 } // namespace glraw
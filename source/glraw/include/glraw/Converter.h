@@ -22,11 +22,12 @@ public:
     Converter();
     virtual ~Converter();
 
-    virtual QByteArray convert(QImage & image, AssetInformation & info);
-
     void setFormat(GLenum format);
     void setType(GLenum type);
 
+protected:
+    virtual bool convertTexture(AssetInformation & info, const DataHandler & handler);
+
 protected:
     GLenum m_format;
     GLenum m_type;
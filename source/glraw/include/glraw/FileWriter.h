@@ -4,8 +4,10 @@
 
 #include <QtGui/qopengl.h>
 #include <QMap>
+#include <QScopedPointer>
 #include <QString>
 #include <QVariant>
+#include <QVector>
 
 #include <glraw/glraw_api.h>
 
@@ -24,34 +26,166 @@ class AssetInformation;
 class GLRAW_API FileWriter
 {
 public:
+    /** Files are written to a temporary file next to the target and renamed into place,
+        so that readers never see partial files. The durability decides when written
+        data is forced to the disk, which protects against power loss as well.
+    */
+    enum class Durability
+    {
+        None,   ///< renamed right away, never synced
+        File,   ///< each file is synced before its rename
+        Group   ///< files are renamed in groups after syncing them together (see setGroupSize())
+    };
+
+    /** Lossless compression of the raw data of uncompressed formats, which is recorded
+        in the header and undone by RawFile transparently.
+    */
+    enum class Compression
+    {
+        None,
+        LZ4     ///< independent chunks, compressed and decompressed on all cores
+    };
+
     FileWriter(bool headerEnabled = true, bool suffixesEnabled = true);
     virtual ~FileWriter();
 
+    /** Writes directly from imageData, which may thus borrow memory, e.g., a mapped
+        pixel buffer via QByteArray::fromRawData(); it is not referenced after returning.
+    */
     virtual bool write(
 		const QByteArray & imageData,
 		const QString & sourcePath,
 		AssetInformation & info);
 
+    /** Probes existing outputs of sourcePath, e.g., to skip its conversion. Since the file
+        suffixes depend on the converted image, all files suffixed like its output are probed.
+        \return Returns true if such a file holds all properties of info with equal values.
+    */
+    bool isUpToDate(
+		const QString & sourcePath,
+		const AssetInformation & info) const;
+
+    /** Makes the output of sourcePath a hard link to the output of originalSourcePath,
+        which was written before with equal data and info, or in pack mode, an entry
+        that references the same data. The header is shared as well, so its source
+        related properties are those of the original.
+        \return Returns false, e.g., for the standard output or if linking failed.
+    */
+    bool writeDuplicate(
+		const QString & sourcePath,
+		const QString & originalSourcePath,
+		const AssetInformation & info);
+
     bool headerEnabled() const;
     void setHeaderEnabled(bool b);
 
     bool suffixesEnabled() const;
     void setSuffixesEnabled(bool b);
+
+    /** If enabled, the header stores a checksum of the raw data before compression
+        (see RawFile::verify()).
+    */
+    bool checksumEnabled() const;
+    void setChecksumEnabled(bool b);
+
+    /** Version 1 headers (default) are followed directly by the raw data. Version 2
+        headers have a fixed-size preamble and pad the raw data offset to dataAlignment().
+    */
+    int headerVersion() const;
+    void setHeaderVersion(int version);
+
+    int dataAlignment() const;
+    void setDataAlignment(int alignment);
+
+    /** Applies to files with header only; raw data that does not shrink is stored as is.
+    */
+    Compression compression() const;
+    void setCompression(Compression compression);
     
+    /** If enabled, files are written to the standard output instead, e.g., into a pipe.
+    */
+    bool standardOutput() const;
+    void setStandardOutput(bool b);
+
+    /** If enabled, each file is preceded by its size as 64 bit little endian integer,
+        so that several files can be told apart within the standard output.
+    */
+    bool framed() const;
+    void setFramed(bool b);
+
+    /** Writes a frame of size 0 to the standard output, e.g., for an input that failed.
+    */
+    bool writeEmptyFrame();
+
+    /** Files whose raw data has at least the given size are written bypassing the page
+        cache (O_DIRECT), so that huge outputs neither evict the cache of other processes
+        nor pile up for writeback. Data is streamed in aligned blocks; the raw data of
+        version 2 headers aligned to multiples of 4096 bytes is written without copying
+        if it is page aligned in memory as well, e.g., a mapped pixel buffer.
+        Falls back to buffered writing where unsupported, e.g., on tmpfs or Windows.
+        \param bytes 0 disables direct writing (default).
+    */
+    qint64 directWriteThreshold() const;
+    void setDirectWriteThreshold(qint64 bytes);
+
+    Durability durability() const;
+    void setDurability(Durability durability);
+
+    /** \param size Number of files per group of Durability::Group; 0 groups all files until flush().
+    */
+    int groupSize() const;
+    void setGroupSize(int size);
+
+    /** Syncs and renames the pending files of the current group.
+    */
+    bool flush();
+
     bool outputPathSet() const;
     void setOutputPath(const QString & path);
 
+    /** Switches to pack mode: write() appends each file, named as it would be named
+        on disk, to a .glpack archive (see RawPack) until closePack() is called.
+    */
+    bool openPack(const QString & path);
+
+    /** Writes the sorted table of contents and closes the archive.
+    */
+    bool closePack();
+    bool packing() const;
+
 protected:
-    void writeHeader(
-		QDataStream & dataStream,
-		QFile & file,
-		AssetInformation & info);
+    /** \return Returns the serialized header, which is empty if info has no properties.
+    */
+    QByteArray header(
+		AssetInformation & info,
+		const QByteArray & imageData) const;
+
+    /** \return Returns the raw data as stored, i.e., compressed if enabled and worthwhile,
+                in which case the compression property is added to info.
+    */
+    QByteArray payload(
+		const QByteArray & imageData,
+		AssetInformation & info) const;
+
+    static QByteArray frame(quint64 size);
 
     static RawFile::PropertyType propertyType(QVariant::Type type);
 
 	static void writeValue(QDataStream & dataStream, const QVariant & value);
     static void writeString(QDataStream & dataStream, const QString & string);
 
+    bool appendToPack(
+		const QByteArray & imageData,
+		const QString & name,
+		AssetInformation & info);
+
+    int packAlignment() const;
+
+    /** Syncs the temporary file per durability and renames it to target, or defers both
+        to flush() for Durability::Group.
+    */
+    bool commit(QFile & file, const QString & target);
+
 protected:
     QString targetFilePath(const QString & sourcePath, const AssetInformation & info);
     QString suffixesForImage(const AssetInformation & info);
@@ -60,6 +194,37 @@ protected:
 protected:
     bool m_headerEnabled;
     bool m_suffixesEnabled;
+    bool m_checksumEnabled;
+    int m_headerVersion;
+    int m_dataAlignment;
+    Compression m_compression;
+    qint64 m_directWriteThreshold;
+
+    struct PackEntry
+    {
+        QByteArray name;
+        quint64 offset;
+        quint64 size;
+    };
+
+    bool m_standardOutput;
+    bool m_framed;
+
+    Durability m_durability;
+    int m_groupSize;
+
+    struct PendingFile
+    {
+        QString temporaryPath;
+        QString targetPath;
+    };
+
+    QVector<PendingFile> m_pendingFiles;
+
+    QScopedPointer<QFile> m_pack;
+    QString m_packPath;
+    quint64 m_packSize;
+    QVector<PackEntry> m_packEntries;
     QString m_outputPath;
 };
 
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QVector>
+
+#include <glraw/glraw_api.h>
+
+
+namespace glraw
+{
+
+/** @brief
+ * High dynamic range image loaded from a Radiance RGBE (.hdr) file.
+ *
+ * Pixels are stored as RGBA floats with the bottom row first, matching the
+ * layout expected by glTexImage2D. Alpha is always 1.
+ */
+class GLRAW_API HDRImage
+{
+public:
+    HDRImage();
+    HDRImage(const QString & fileName);
+    ~HDRImage();
+
+    /** \return Returns true if the file starts with a Radiance signature.
+    */
+    static bool canRead(const QString & fileName);
+    static bool canReadData(const QByteArray & data);
+
+    bool load(const QString & fileName);
+    bool loadFromData(const QByteArray & data);
+
+    bool isNull() const;
+
+    int width() const;
+    int height() const;
+
+    const float * bits() const;
+
+protected:
+    int m_width;
+    int m_height;
+
+    QVector<float> m_pixels;
+};
+
+} // namespace glraw
@@ -0,0 +1,244 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+
+namespace glraw
+{
+
+/** @brief
+ * LZ4 block codec, compatible with the reference implementation's block format.
+ *
+ * Header-only like RawFile, so that applications decompress without linking glraw.
+ * Compressed raw data is stored in independent chunks, which are compressed and
+ * decompressed in parallel:
+ *
+ *   u64 uncompressed size, u32 chunk size, u32 chunk count,
+ *   u32 stored size per chunk (s_uncompressedChunk set if stored as is), chunk data
+ */
+namespace lz4
+{
+
+const size_t s_chunkTableOffset = 16;
+const uint32_t s_uncompressedChunk = 0x80000000u;
+
+const size_t s_minMatch = 4;
+const size_t s_lastLiterals = 5;     // the last 5 bytes are always literals
+const size_t s_matchSearchLimit = 12; // the last match starts at least 12 bytes before the end
+const int s_hashBits = 12;
+
+/** \return Returns the maximum compressed size of size bytes.
+*/
+inline size_t compressBound(size_t size)
+{
+    return size + size / 255 + 16;
+}
+
+namespace detail
+{
+
+inline uint32_t read32(const unsigned char * data)
+{
+    uint32_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash(uint32_t sequence)
+{
+    return (sequence * 2654435761u) >> (32 - s_hashBits);
+}
+
+inline unsigned char * writeLength(unsigned char * it, size_t length)
+{
+    for (; length >= 255; length -= 255)
+        *it++ = 255;
+
+    *it++ = static_cast<unsigned char>(length);
+    return it;
+}
+
+inline unsigned char * writeSequence(unsigned char * it, const unsigned char * literals
+    , size_t literalCount, size_t offset, size_t matchLength)
+{
+    unsigned char * token = it++;
+    *token = static_cast<unsigned char>(std::min<size_t>(literalCount, 15) << 4);
+
+    if (literalCount >= 15)
+        it = writeLength(it, literalCount - 15);
+
+    if (literalCount > 0)
+        std::memcpy(it, literals, literalCount);
+
+    it += literalCount;
+
+    // the last sequence holds literals only
+    if (matchLength == 0)
+        return it;
+
+    *it++ = static_cast<unsigned char>(offset);
+    *it++ = static_cast<unsigned char>(offset >> 8);
+
+    matchLength -= s_minMatch;
+    *token |= static_cast<unsigned char>(std::min<size_t>(matchLength, 15));
+
+    if (matchLength >= 15)
+        it = writeLength(it, matchLength - 15);
+
+    return it;
+}
+
+} // namespace detail
+
+/** Compresses size bytes greedily with a single-entry hash table, which trades
+    ratio for speed like the reference implementation's default.
+    \param destination Has to hold compressBound(size) bytes.
+    \return Returns the compressed size.
+*/
+inline size_t compress(const char * source, size_t size, char * destination)
+{
+    const unsigned char * const src = reinterpret_cast<const unsigned char *>(source);
+    unsigned char * const dst = reinterpret_cast<unsigned char *>(destination);
+    unsigned char * out = dst;
+
+    size_t anchor = 0;
+
+    if (size > s_matchSearchLimit)
+    {
+        // positions + 1, so that 0 marks empty entries
+        uint32_t table[1 << s_hashBits] = { };
+
+        const size_t searchEnd = size - s_matchSearchLimit;
+        const size_t matchEnd = size - s_lastLiterals;
+
+        size_t position = 0;
+
+        while (position <= searchEnd)
+        {
+            const uint32_t sequence = detail::read32(src + position);
+            const uint32_t h = detail::hash(sequence);
+            const size_t candidate = table[h];
+            table[h] = static_cast<uint32_t>(position + 1);
+
+            if (candidate == 0 || position - (candidate - 1) > 0xFFFF
+                || detail::read32(src + candidate - 1) != sequence)
+            {
+                // skip faster through incompressible data
+                position += 1 + ((position - anchor) >> 6);
+                continue;
+            }
+
+            const size_t match = candidate - 1;
+            size_t length = s_minMatch;
+
+            while (position + length < matchEnd && src[match + length] == src[position + length])
+                ++length;
+
+            out = detail::writeSequence(out, src + anchor, position - anchor, position - match, length);
+
+            position += length;
+            anchor = position;
+        }
+    }
+
+    out = detail::writeSequence(out, src + anchor, size - anchor, 0, 0);
+
+    return static_cast<size_t>(out - dst);
+}
+
+/** Decompresses a block of exactly decompressedSize bytes, checking all bounds,
+    so that corrupted input cannot read or write out of bounds.
+    \return Returns false if source is no valid block of decompressedSize bytes.
+*/
+inline bool decompress(const char * source, size_t size, char * destination, size_t decompressedSize)
+{
+    const unsigned char * in = reinterpret_cast<const unsigned char *>(source);
+    const unsigned char * const inEnd = in + size;
+    unsigned char * const dst = reinterpret_cast<unsigned char *>(destination);
+    unsigned char * out = dst;
+    unsigned char * const outEnd = dst + decompressedSize;
+
+    for (;;)
+    {
+        if (in == inEnd)
+            return false;
+
+        const unsigned char token = *in++;
+        size_t literalCount = token >> 4;
+
+        if (literalCount == 15)
+        {
+            unsigned char byte;
+            do
+            {
+                if (in == inEnd)
+                    return false;
+
+                byte = *in++;
+                literalCount += byte;
+            } while (byte == 255);
+        }
+
+        if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(outEnd - out))
+            return false;
+
+        if (literalCount > 0)
+            std::memcpy(out, in, literalCount);
+
+        in += literalCount;
+        out += literalCount;
+
+        if (in == inEnd)
+            break;
+
+        if (inEnd - in < 2)
+            return false;
+
+        const size_t offset = in[0] | (in[1] << 8);
+        in += 2;
+
+        if (offset == 0 || offset > static_cast<size_t>(out - dst))
+            return false;
+
+        size_t length = token & 15;
+
+        if (length == 15)
+        {
+            unsigned char byte;
+            do
+            {
+                if (in == inEnd)
+                    return false;
+
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+        }
+
+        length += s_minMatch;
+
+        if (length > static_cast<size_t>(outEnd - out))
+            return false;
+
+        // matches may overlap their own output, e.g., runs with offset 1
+        const unsigned char * match = out - offset;
+
+        if (offset >= length)
+            std::memcpy(out, match, length);
+        else
+        {
+            for (size_t i = 0; i < length; ++i)
+                out[i] = match[i];
+        }
+
+        out += length;
+    }
+
+    return out == outEnd;
+}
+
+} // namespace lz4
+
+} // namespace glraw
@@ -3,18 +3,22 @@
 #include <cstdint>
 #include <string>
 #include <vector>
-#include <map>
-
-#include <glraw/glraw_api.h>
+#include <iosfwd>
 
 
 namespace glraw
 {
 
-class GLRAW_API RawFile
+/** @brief
+ * Reader for .glraw files.
+ *
+ * Header-only and depending on the standard library and the platform API only,
+ * so applications can load .glraw files without linking glraw or Qt.
+ */
+class RawFile
 {
 public:
-    static uint16_t s_signature;
+    static const uint16_t s_signature = 0xC6F5;
 
     enum class PropertyType 
 	{
@@ -24,13 +28,57 @@ public:
         String	= 3
     };
 
-    RawFile(const std::string & filePath, bool parseProperties = true);
+    /** Specifies how the raw data is made available through data().
+    */
+    enum class Access
+    {
+        Read,           ///< raw data is copied into memory owned by the RawFile
+        Map,            ///< raw data is memory mapped and paged in on first access
+        MapSequential,  ///< memory mapped, advising the kernel to read ahead aggressively
+        MapRandom,      ///< memory mapped, advising the kernel to avoid read ahead
+        HeaderOnly,     ///< only signature and properties are read, data() is empty
+        Stream          ///< as HeaderOnly, but the file stays open for readRows() and readRegion()
+    };
+
+    /** Never throws: files that cannot be read, e.g., for lack of memory, are invalid instead
+        (see isValid()), so that worker threads may construct RawFiles unguarded.
+    */
+    RawFile(const std::string & filePath, bool parseProperties = true, Access access = Access::Read);
+
+    /** Reads a .glraw file from memory, e.g., an entry of a RawPack. Nothing is copied:
+        data() and the properties reference the given memory, which has to outlive the RawFile.
+        Only compressed raw data is decompressed into memory owned by the RawFile.
+    */
+    RawFile(const char * data, size_t size, bool parseProperties);
+
     virtual ~RawFile();
 
+    RawFile(const RawFile &) = delete;
+    RawFile & operator=(const RawFile &) = delete;
+
+    /** \return Returns the raw data; points into the file mapping if the file is mapped.
+    */
     const char * data() const;
     const size_t size() const;
 
     bool isValid() const;
+    bool isMapped() const;
+
+    /** Compressed raw data (see the compression property) is decompressed in parallel
+        chunks on construction if properties are parsed, so that data() holds it as
+        written by the converter. Parts of it cannot be read, though: readRows(),
+        readRegion() and readTile() fail for compressed files.
+        \return Returns true if the raw data is stored compressed.
+    */
+    bool isCompressed() const;
+
+    /** \return Returns the header version: 0 for headerless files, 1 or 2 otherwise.
+    */
+    uint8_t version() const;
+
+    /** \return Returns the offset of the raw data within the file; aligned for v2 headers.
+    */
+    uint64_t dataOffset() const;
     const std::string & filePath() const;
     
     const std::string & stringProperty(const std::string & key) const;
@@ -41,23 +89,104 @@ public:
     bool hasIntProperty(const std::string & key) const;
     bool hasDoubleProperty(const std::string & key) const;
 
+    /** \return Returns the XXH64 hash of data as written to the checksum property.
+    */
+    static uint64_t checksum(const char * data, size_t size);
+
+    /** Hashes the raw data and compares it to the checksum property, which detects
+        truncated and corrupted payloads. Requires Access::Read or a mapped access.
+        \return Returns false if the file has no checksum or the raw data does not match.
+    */
+    bool verify() const;
+
+    /** \return Returns the size of a pixel in bytes derived from the format and type 
+                properties; 0 for compressed or unknown formats.
+    */
+    size_t pixelSize() const;
+
+    /** Reads rows [firstRow, firstRow + rowCount) of uncompressed raw data into buffer
+        using a single positioned read. Requires Access::Stream and parsed properties.
+        \return Returns false if the rows are out of bounds, the layout is unknown or tiled,
+                or reading failed.
+    */
+    bool readRows(int firstRow, int rowCount, char * buffer) const;
+
+    /** Reads a rectangle of uncompressed raw data into buffer, with its rows tightly packed.
+        Requires Access::Stream and parsed properties.
+        \return Returns false if the rectangle is out of bounds, the layout is unknown or tiled,
+                or reading failed.
+    */
+    bool readRegion(int x, int y, int width, int height, char * buffer) const;
+
+    /** Reads one tile of tiled raw data (see the tileBytes property) into buffer with a
+        single positioned read. Requires Access::Stream and parsed properties.
+        \return Returns false if the file is not tiled, the tile does not exist, or reading failed.
+    */
+    bool readTile(int column, int row, char * buffer) const;
+
 protected:
-    bool readFile(bool parseProperties);
-    
-    void readProperties(std::ifstream & ifs, uint64_t offset);
-    void readStringProperties(std::ifstream & ifs);
-    void readIntProperties(std::ifstream & ifs);
-    void readDoubleProperties(std::ifstream & ifs);
+    /** Property whose key references the header block, either m_header or the file mapping.
+    */
+    struct Property
+    {
+        const char * key;
+        size_t keyLength;
+        PropertyType type;
+
+        int32_t intValue;
+        double doubleValue;
+        std::string stringValue;
+    };
+
+protected:
+    bool readFile(bool parseProperties, Access access);
+
+    /** Sets m_dataOffset, which is 0 for headerless files.
+        \return Returns false if the header's data offset lies beyond the end of the file.
+    */
+    bool readHeader(std::ifstream & ifs, bool parseProperties);
+    bool readHeader(const char * data, size_t size, bool parseProperties);
+
+    /** Parses the property block in place and sorts the properties by key and type.
+    */
+    void readProperties(const char * begin, const char * end);
     
     void readRawData(std::ifstream & ifs, uint64_t offset);
 
+    /** Replaces compressed raw data by its decompressed bytes in m_data.
+        \return Returns false if the compression is unknown or the raw data is corrupted.
+    */
+    bool decompress();
+
+    bool mapFile(bool parseProperties, Access access);
+    void unmapFile();
+
+    bool openFile();
+    void closeFile();
+    bool readAt(uint64_t offset, char * buffer, size_t size) const;
+    bool fileSize(uint64_t & size) const;
+
+    const Property * findProperty(const std::string & key, PropertyType type) const;
+
 protected:
     const std::string m_filePath;
     std::vector<char> m_data;
+    std::vector<char> m_header;
+
+    void * m_mapping;
+    size_t m_mappingSize;
+    bool m_borrowed;
+
+    // data() returns m_data instead of the mapping, which still holds the properties
+    bool m_decompressed;
+
+    // file descriptor or handle kept open for Access::Stream, -1 otherwise
+    intptr_t m_fileHandle;
+
+    uint64_t m_dataOffset;
+    uint8_t m_version;
 
-    std::map<std::string, std::string> m_stringProperties;
-    std::map<std::string, int32_t> m_intProperties;
-    std::map<std::string, double> m_doubleProperties;
+    std::vector<Property> m_properties;
 
     bool m_valid;
 
@@ -65,3 +194,4 @@ protected:
 
 } // namespace glraw
 
+#include <glraw/RawFile.hpp>
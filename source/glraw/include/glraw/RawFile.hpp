@@ -0,0 +1,1022 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <stdio.h>
+#include <thread>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#endif
+
+#include <glraw/LZ4.h>
+
+
+namespace glraw
+{
+
+namespace detail
+{
+
+// signature followed by the raw data offset
+const size_t s_preambleSize = sizeof(uint16_t) + sizeof(uint64_t);
+
+// v1 preamble followed by a zero marker, the version, the property block size,
+// the data alignment and reserved bytes (see FileWriter::writeHeader)
+const size_t s_preambleSizeV2 = 32;
+
+template<typename T>
+inline T read(const char * data)
+{
+    T value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+struct Preamble
+{
+    uint8_t version;
+    uint64_t dataOffset;
+    uint64_t propertiesOffset;
+    uint64_t propertiesSize;
+};
+
+/** Parses the first size bytes of a file; v2 is detected only if size covers its preamble.
+    v1 files start their property block with a type byte > 0 where v2 files hold the zero
+    marker, so that v1 readers skip the v2 properties but still find the raw data.
+*/
+inline bool readPreamble(const char * data, size_t size, uint16_t signature, Preamble & preamble)
+{
+    if (size < s_preambleSize || read<uint16_t>(data) != signature)
+        return false;
+
+    preamble.version = 1;
+    preamble.dataOffset = read<uint64_t>(data + sizeof(uint16_t));
+    preamble.propertiesOffset = s_preambleSize;
+    preamble.propertiesSize = preamble.dataOffset - s_preambleSize;
+
+    if (preamble.dataOffset < s_preambleSize)
+        return false;
+
+    if (size < s_preambleSizeV2 || preamble.dataOffset < s_preambleSizeV2 || data[10] != 0)
+        return true;
+
+    preamble.version = static_cast<uint8_t>(data[11]);
+    preamble.propertiesOffset = s_preambleSizeV2;
+    preamble.propertiesSize = std::min<uint64_t>(read<uint32_t>(data + 12), preamble.dataOffset - s_preambleSizeV2);
+
+    return preamble.version >= 2;
+}
+
+inline size_t componentCount(int32_t format)
+{
+    switch (format)
+    {
+    case 0x1903: // GL_RED
+    case 0x1904: // GL_GREEN
+    case 0x1905: // GL_BLUE
+        return 1;
+    case 0x8227: // GL_RG
+        return 2;
+    case 0x1907: // GL_RGB
+    case 0x80E0: // GL_BGR
+        return 3;
+    case 0x1908: // GL_RGBA
+    case 0x80E1: // GL_BGRA
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+inline size_t pixelSizeOf(int32_t format, int32_t type)
+{
+    switch (type)
+    {
+    case 0x1400: // GL_BYTE
+    case 0x1401: // GL_UNSIGNED_BYTE
+        return componentCount(format);
+    case 0x1402: // GL_SHORT
+    case 0x1403: // GL_UNSIGNED_SHORT
+    case 0x140B: // GL_HALF_FLOAT
+        return componentCount(format) * 2;
+    case 0x1404: // GL_INT
+    case 0x1405: // GL_UNSIGNED_INT
+    case 0x1406: // GL_FLOAT
+        return componentCount(format) * 4;
+    case 0x8363: // GL_UNSIGNED_SHORT_5_6_5
+    case 0x8033: // GL_UNSIGNED_SHORT_4_4_4_4
+    case 0x8034: // GL_UNSIGNED_SHORT_5_5_5_1
+        return 2;
+    case 0x8036: // GL_UNSIGNED_INT_10_10_10_2
+    case 0x8368: // GL_UNSIGNED_INT_2_10_10_10_REV
+    case 0x8C3B: // GL_UNSIGNED_INT_10F_11F_11F_REV
+    case 0x8C3E: // GL_UNSIGNED_INT_5_9_9_9_REV
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+inline int compareKeys(const char * a, size_t aLength, const char * b, size_t bLength)
+{
+    const int result = std::memcmp(a, b, std::min(aLength, bLength));
+
+    if (result != 0)
+        return result;
+
+    return aLength < bLength ? -1 : (aLength > bLength ? 1 : 0);
+}
+
+const uint64_t s_prime1 = 11400714785074694791ULL;
+const uint64_t s_prime2 = 14029467366897019727ULL;
+const uint64_t s_prime3 = 1609587929392839161ULL;
+const uint64_t s_prime4 = 9650029242287828579ULL;
+const uint64_t s_prime5 = 2870177450012600261ULL;
+
+inline uint64_t rotateLeft(uint64_t value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+inline uint64_t accumulate(uint64_t accumulator, uint64_t input)
+{
+    return rotateLeft(accumulator + input * s_prime2, 31) * s_prime1;
+}
+
+inline uint64_t merge(uint64_t accumulator, uint64_t value)
+{
+    return (accumulator ^ accumulate(0, value)) * s_prime1 + s_prime4;
+}
+
+// XXH64 with seed 0
+inline uint64_t xxh64(const char * data, size_t size)
+{
+    const char * const end = data + size;
+    uint64_t hash;
+
+    if (size >= 32)
+    {
+        uint64_t v1 = s_prime1 + s_prime2;
+        uint64_t v2 = s_prime2;
+        uint64_t v3 = 0;
+        uint64_t v4 = 0 - s_prime1;
+
+        for (const char * const limit = end - 32; data <= limit; data += 32)
+        {
+            v1 = accumulate(v1, read<uint64_t>(data));
+            v2 = accumulate(v2, read<uint64_t>(data + 8));
+            v3 = accumulate(v3, read<uint64_t>(data + 16));
+            v4 = accumulate(v4, read<uint64_t>(data + 24));
+        }
+
+        hash = rotateLeft(v1, 1) + rotateLeft(v2, 7) + rotateLeft(v3, 12) + rotateLeft(v4, 18);
+        hash = merge(merge(merge(merge(hash, v1), v2), v3), v4);
+    }
+    else
+    {
+        hash = s_prime5;
+    }
+
+    hash += size;
+
+    for (; data + 8 <= end; data += 8)
+        hash = rotateLeft(hash ^ accumulate(0, read<uint64_t>(data)), 27) * s_prime1 + s_prime4;
+
+    if (data + 4 <= end)
+    {
+        hash = rotateLeft(hash ^ (read<uint32_t>(data) * s_prime1), 23) * s_prime2 + s_prime3;
+        data += 4;
+    }
+
+    for (; data < end; ++data)
+        hash = rotateLeft(hash ^ (static_cast<uint8_t>(*data) * s_prime5), 11) * s_prime1;
+
+    hash ^= hash >> 33;
+    hash *= s_prime2;
+    hash ^= hash >> 29;
+    hash *= s_prime3;
+    hash ^= hash >> 32;
+
+    return hash;
+}
+
+/** Decompresses chunked LZ4 raw data (see lz4) into data, one chunk per task on all cores.
+    \return Returns false if the chunk table or any chunk is corrupted.
+*/
+inline bool decompressChunks(const char * payload, size_t size, std::vector<char> & data)
+{
+    if (size < lz4::s_chunkTableOffset)
+        return false;
+
+    const uint64_t uncompressedSize = read<uint64_t>(payload);
+    const uint32_t chunkSize = read<uint32_t>(payload + 8);
+    const uint32_t chunkCount = read<uint32_t>(payload + 12);
+
+    if (chunkSize == 0 || uncompressedSize > static_cast<size_t>(-1) / 2
+        || uncompressedSize / chunkSize + (uncompressedSize % chunkSize != 0) != chunkCount
+        || chunkCount > (size - lz4::s_chunkTableOffset) / sizeof(uint32_t))
+        return false;
+
+    const char * const table = payload + lz4::s_chunkTableOffset;
+
+    std::vector<size_t> offsets(chunkCount + 1);
+    offsets[0] = lz4::s_chunkTableOffset + chunkCount * sizeof(uint32_t);
+
+    for (uint32_t i = 0; i < chunkCount; ++i)
+    {
+        offsets[i + 1] = offsets[i] + (read<uint32_t>(table + i * sizeof(uint32_t)) & ~lz4::s_uncompressedChunk);
+
+        if (offsets[i + 1] > size)
+            return false;
+    }
+
+    data.resize(static_cast<size_t>(uncompressedSize));
+
+    std::atomic<uint32_t> next(0);
+    std::atomic<bool> failed(false);
+
+    auto work = [&]()
+    {
+        for (uint32_t i = next++; i < chunkCount && !failed; i = next++)
+        {
+            const size_t begin = static_cast<size_t>(i) * chunkSize;
+            const size_t length = std::min<size_t>(chunkSize, data.size() - begin);
+
+            const char * const chunk = payload + offsets[i];
+            const size_t storedSize = offsets[i + 1] - offsets[i];
+
+            if (read<uint32_t>(table + i * sizeof(uint32_t)) & lz4::s_uncompressedChunk)
+            {
+                if (storedSize != length)
+                    failed = true;
+                else
+                    std::memcpy(data.data() + begin, chunk, length);
+            }
+            else if (!lz4::decompress(chunk, storedSize, data.data() + begin, length))
+                failed = true;
+        }
+    };
+
+    const uint32_t threadCount = std::min(chunkCount, std::max(1u, std::thread::hardware_concurrency()));
+
+    // the calling thread takes chunks as well
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i)
+        threads.emplace_back(work);
+
+    work();
+
+    for (auto & thread : threads)
+        thread.join();
+
+    return !failed;
+}
+
+} // namespace detail
+
+
+inline RawFile::RawFile(const std::string & filePath, bool parseProperties, Access access)
+: m_filePath(filePath)
+, m_mapping(nullptr)
+, m_mappingSize(0)
+, m_borrowed(false)
+, m_decompressed(false)
+, m_fileHandle(-1)
+, m_dataOffset(0)
+, m_version(0)
+, m_valid(false)
+{
+    // e.g., std::bad_alloc for raw data exceeding the memory, which makes the file invalid
+    // instead of terminating worker threads that load or scan files
+    try
+    {
+        m_valid = readFile(parseProperties, access);
+    }
+    catch (const std::exception & exception)
+    {
+        fprintf(stderr, "Error: Reading %s failed: %s\n", m_filePath.c_str(), exception.what());
+        m_valid = false;
+    }
+}
+
+
+inline RawFile::RawFile(const char * data, size_t size, bool parseProperties)
+: m_mapping(const_cast<char *>(data))
+, m_mappingSize(size)
+, m_borrowed(true)
+, m_decompressed(false)
+, m_fileHandle(-1)
+, m_dataOffset(0)
+, m_version(0)
+, m_valid(data != nullptr)
+{
+    if (!m_valid)
+        return;
+
+    try
+    {
+        m_valid = readHeader(data, size, parseProperties) && decompress();
+    }
+    catch (const std::exception & exception)
+    {
+        fprintf(stderr, "Error: Reading raw data failed: %s\n", exception.what());
+        m_valid = false;
+    }
+}
+
+
+inline RawFile::~RawFile()
+{
+    unmapFile();
+    closeFile();
+}
+
+
+inline bool RawFile::isValid() const
+{
+    return m_valid;
+}
+
+
+inline uint8_t RawFile::version() const
+{
+    return m_version;
+}
+
+
+inline uint64_t RawFile::dataOffset() const
+{
+    return m_dataOffset;
+}
+
+
+inline bool RawFile::isMapped() const
+{
+    return m_mapping != nullptr;
+}
+
+
+inline bool RawFile::isCompressed() const
+{
+    return findProperty("compression", PropertyType::String) != nullptr;
+}
+
+
+inline const std::string & RawFile::filePath() const
+{
+    return m_filePath;
+}
+
+
+inline const char * RawFile::data() const
+{
+    if (isMapped() && !m_decompressed)
+        return static_cast<const char *>(m_mapping) + m_dataOffset;
+
+    return m_data.data();
+}
+
+
+inline const size_t RawFile::size() const
+{
+    if (isMapped() && !m_decompressed)
+        return static_cast<size_t>(m_mappingSize - m_dataOffset);
+
+    return m_data.size();
+}
+
+
+inline const std::string & RawFile::stringProperty(const std::string & key) const
+{
+    const Property * property = findProperty(key, PropertyType::String);
+
+    if (!property)
+        throw std::out_of_range("RawFile: no string property " + key);
+
+    return property->stringValue;
+}
+
+
+inline int32_t RawFile::intProperty(const std::string & key) const
+{
+    const Property * property = findProperty(key, PropertyType::Int);
+
+    if (!property)
+        throw std::out_of_range("RawFile: no int property " + key);
+
+    return property->intValue;
+}
+
+
+inline double RawFile::doubleProperty(const std::string & key) const
+{
+    const Property * property = findProperty(key, PropertyType::Double);
+
+    if (!property)
+        throw std::out_of_range("RawFile: no double property " + key);
+
+    return property->doubleValue;
+}
+
+
+inline bool RawFile::hasStringProperty(const std::string & key) const
+{
+    return findProperty(key, PropertyType::String) != nullptr;
+}
+
+
+inline bool RawFile::hasIntProperty(const std::string & key) const
+{
+    return findProperty(key, PropertyType::Int) != nullptr;
+}
+
+
+inline bool RawFile::hasDoubleProperty(const std::string & key) const
+{
+    return findProperty(key, PropertyType::Double) != nullptr;
+}
+
+inline uint64_t RawFile::checksum(const char * data, size_t size)
+{
+    return detail::xxh64(data, size);
+}
+
+inline bool RawFile::verify() const
+{
+    const Property * property = findProperty("checksum", PropertyType::String);
+
+    if (!property || property->stringValue.size() != 16 || (m_data.empty() && !m_mapping))
+        return false;
+
+    char * end = nullptr;
+    const uint64_t expected = strtoull(property->stringValue.c_str(), &end, 16);
+
+    if (*end != '\0')
+        return false;
+
+    return checksum(data(), size()) == expected;
+}
+
+inline size_t RawFile::pixelSize() const
+{
+    const Property * format = findProperty("format", PropertyType::Int);
+    const Property * type = findProperty("type", PropertyType::Int);
+
+    if (!format || !type)
+        return 0;
+
+    return detail::pixelSizeOf(format->intValue, type->intValue);
+}
+
+inline bool RawFile::readRows(int firstRow, int rowCount, char * buffer) const
+{
+    const Property * width = findProperty("width", PropertyType::Int);
+
+    if (!width)
+        return false;
+
+    return readRegion(0, firstRow, width->intValue, rowCount, buffer);
+}
+
+inline bool RawFile::readRegion(int x, int y, int width, int height, char * buffer) const
+{
+    const Property * imageWidth = findProperty("width", PropertyType::Int);
+    const Property * imageHeight = findProperty("height", PropertyType::Int);
+    const size_t pixelSize = this->pixelSize();
+
+    // tiled raw data is not laid out in rows (see readTile())
+    if (m_fileHandle == -1 || isCompressed() || findProperty("tileBytes", PropertyType::Int)
+        || !imageWidth || !imageHeight || pixelSize == 0)
+        return false;
+
+    if (x < 0 || y < 0 || width < 0 || height < 0
+        || static_cast<int64_t>(x) + width > imageWidth->intValue
+        || static_cast<int64_t>(y) + height > imageHeight->intValue)
+        return false;
+
+    const uint64_t stride = static_cast<uint64_t>(imageWidth->intValue) * pixelSize;
+    const size_t rowSize = static_cast<size_t>(width) * pixelSize;
+
+    // full rows are contiguous in the file
+    if (width == imageWidth->intValue)
+        return readAt(m_dataOffset + y * stride, buffer, rowSize * height);
+
+    for (int row = 0; row < height; ++row)
+    {
+        const uint64_t offset = m_dataOffset + (y + row) * stride + x * pixelSize;
+
+        if (!readAt(offset, buffer + row * rowSize, rowSize))
+            return false;
+    }
+
+    return true;
+}
+
+inline bool RawFile::readTile(int column, int row, char * buffer) const
+{
+    const Property * columns = findProperty("tileColumns", PropertyType::Int);
+    const Property * rows = findProperty("tileRows", PropertyType::Int);
+    const Property * bytes = findProperty("tileBytes", PropertyType::Int);
+
+    if (m_fileHandle == -1 || isCompressed() || !columns || !rows || !bytes || bytes->intValue <= 0)
+        return false;
+
+    if (column < 0 || row < 0 || column >= columns->intValue || row >= rows->intValue)
+        return false;
+
+    const uint64_t index = static_cast<uint64_t>(row) * columns->intValue + column;
+
+    return readAt(m_dataOffset + index * bytes->intValue, buffer, static_cast<size_t>(bytes->intValue));
+}
+
+inline bool RawFile::readFile(bool parseProperties, Access access)
+{
+    if (access == Access::Stream)
+    {
+        if (!openFile())
+            return false;
+
+        char header[detail::s_preambleSizeV2];
+        size_t size = detail::s_preambleSize;
+
+        if (!readAt(0, header, size))
+            return true;
+
+        if (readAt(size, header + size, sizeof(header) - size))
+            size = sizeof(header);
+
+        detail::Preamble preamble;
+        if (!detail::readPreamble(header, size, s_signature, preamble))
+            return true;
+
+        // the offset is checked before the property block is allocated by its size
+        uint64_t fileSize;
+        if (!this->fileSize(fileSize) || preamble.dataOffset > fileSize)
+        {
+            fprintf(stderr, "Error: The data offset of %s lies beyond its end.\n", m_filePath.c_str());
+            return false;
+        }
+
+        m_version = preamble.version;
+        m_dataOffset = preamble.dataOffset;
+
+        if (parseProperties)
+        {
+            m_header.resize(static_cast<size_t>(preamble.propertiesSize));
+
+            if (!readAt(preamble.propertiesOffset, m_header.data(), m_header.size()))
+                return false;
+
+            readProperties(m_header.data(), m_header.data() + m_header.size());
+        }
+
+        return true;
+    }
+
+    if (access != Access::Read && access != Access::HeaderOnly)
+        return mapFile(parseProperties, access) && decompress();
+
+    std::ifstream ifs(m_filePath, std::ios::in | std::ios::binary);
+
+    if (!ifs)
+    {
+        perror("Error");
+        return false;
+    }
+    
+    if (!readHeader(ifs, parseProperties))
+        return false;
+
+    if (access == Access::HeaderOnly)
+        return true;
+
+    readRawData(ifs, m_dataOffset);
+    ifs.close();
+
+    return decompress();
+}
+
+inline bool RawFile::readHeader(std::ifstream & ifs, bool parseProperties)
+{
+    char header[detail::s_preambleSizeV2];
+    ifs.read(header, sizeof(header));
+
+    detail::Preamble preamble;
+    if (!detail::readPreamble(header, static_cast<size_t>(ifs.gcount()), s_signature, preamble))
+    {
+        ifs.clear();
+        m_dataOffset = 0;
+        return true;
+    }
+
+    ifs.clear();
+    ifs.seekg(0, std::ios::end);
+    const uint64_t fileSize = static_cast<uint64_t>(ifs.tellg());
+
+    // the offset is checked before the property block is allocated by its size
+    if (preamble.dataOffset > fileSize)
+    {
+        fprintf(stderr, "Error: The data offset of %s lies beyond its end.\n", m_filePath.c_str());
+        return false;
+    }
+
+    m_version = preamble.version;
+    m_dataOffset = preamble.dataOffset;
+
+    if (!parseProperties)
+        return true;
+
+    // the whole property block is read at once and parsed in place
+    m_header.resize(static_cast<size_t>(preamble.propertiesSize));
+
+    ifs.clear();
+    ifs.seekg(preamble.propertiesOffset);
+    ifs.read(m_header.data(), m_header.size());
+
+    readProperties(m_header.data(), m_header.data() + ifs.gcount());
+    ifs.clear();
+
+    return true;
+}
+
+inline bool RawFile::readHeader(const char * data, size_t size, bool parseProperties)
+{
+    detail::Preamble preamble;
+
+    m_dataOffset = 0;
+
+    if (!detail::readPreamble(data, size, s_signature, preamble))
+        return true;
+
+    if (preamble.dataOffset > size)
+    {
+        fprintf(stderr, "Error: The data offset of %s lies beyond its end.\n", m_filePath.c_str());
+        return false;
+    }
+
+    m_version = preamble.version;
+    m_dataOffset = preamble.dataOffset;
+
+    if (parseProperties)
+    {
+        const uint64_t begin = std::min(preamble.propertiesOffset, m_dataOffset);
+        readProperties(data + begin, data + std::min(begin + preamble.propertiesSize, m_dataOffset));
+    }
+
+    return true;
+}
+
+inline void RawFile::readProperties(const char * it, const char * end)
+{
+    m_properties.clear();
+
+    while (it < end)
+    {
+        Property property;
+        property.type = static_cast<PropertyType>(static_cast<uint8_t>(*it++));
+        property.intValue = 0;
+        property.doubleValue = 0.0;
+
+        const char * keyEnd = static_cast<const char *>(std::memchr(it, '\0', end - it));
+        if (!keyEnd)
+            break;
+
+        property.key = it;
+        property.keyLength = keyEnd - it;
+        it = keyEnd + 1;
+
+        if (property.type == PropertyType::Int && end - it >= static_cast<ptrdiff_t>(sizeof(int32_t)))
+        {
+            property.intValue = detail::read<int32_t>(it);
+            it += sizeof(int32_t);
+        }
+        else if (property.type == PropertyType::Double && end - it >= static_cast<ptrdiff_t>(sizeof(double)))
+        {
+            property.doubleValue = detail::read<double>(it);
+            it += sizeof(double);
+        }
+        else if (property.type == PropertyType::String && it < end)
+        {
+            const char * valueEnd = static_cast<const char *>(std::memchr(it, '\0', end - it));
+            if (!valueEnd)
+                break;
+
+            property.stringValue.assign(it, valueEnd);
+            it = valueEnd + 1;
+        }
+        else
+            break;
+
+        m_properties.push_back(std::move(property));
+    }
+
+    // stable, so that the last of several equal keys wins (see findProperty)
+    std::stable_sort(m_properties.begin(), m_properties.end(), 
+        [](const Property & a, const Property & b)
+    {
+        const int result = detail::compareKeys(a.key, a.keyLength, b.key, b.keyLength);
+        return result < 0 || (result == 0 && a.type < b.type);
+    });
+}
+
+inline void RawFile::readRawData(std::ifstream & ifs, uint64_t rawDataOffset)
+{
+    ifs.seekg(0, std::ios::end);
+    
+    const uint64_t endPosition = static_cast<uint64_t>(ifs.tellg());
+    const size_t size = static_cast<size_t>(endPosition > rawDataOffset ? endPosition - rawDataOffset : 0);
+    
+    ifs.seekg(rawDataOffset, std::ios::beg);
+
+    m_data.resize(size);
+
+    ifs.read(m_data.data(), size);
+}
+
+inline bool RawFile::decompress()
+{
+    const Property * compression = findProperty("compression", PropertyType::String);
+
+    if (!compression)
+        return true;
+
+    if (compression->stringValue != "lz4")
+    {
+        fprintf(stderr, "Error: %s uses the unknown compression %s.\n", m_filePath.c_str(), compression->stringValue.c_str());
+        return false;
+    }
+
+    std::vector<char> data;
+
+    if (!detail::decompressChunks(this->data(), size(), data))
+    {
+        fprintf(stderr, "Error: Decompressing %s failed.\n", m_filePath.c_str());
+        return false;
+    }
+
+    m_data.swap(data);
+    m_decompressed = true;
+
+    return true;
+}
+
+inline bool RawFile::mapFile(bool parseProperties, Access access)
+{
+    // the whole file is mapped, since mapping offsets need to be page aligned
+
+#ifdef _WIN32
+    DWORD flags = FILE_ATTRIBUTE_NORMAL;
+    if (access == Access::MapSequential)
+        flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+    else if (access == Access::MapRandom)
+        flags |= FILE_FLAG_RANDOM_ACCESS;
+
+    HANDLE file = CreateFileA(m_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ
+        , nullptr, OPEN_EXISTING, flags, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Error: Opening %s for mapping failed.\n", m_filePath.c_str());
+        return false;
+    }
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize))
+    {
+        fprintf(stderr, "Error: Querying the size of %s failed.\n", m_filePath.c_str());
+        CloseHandle(file);
+        return false;
+    }
+
+    // empty files cannot be mapped
+    if (fileSize.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return true;
+    }
+
+    // the view keeps the mapping and the file alive
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+    {
+        fprintf(stderr, "Error: Mapping %s failed.\n", m_filePath.c_str());
+        return false;
+    }
+
+    void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+
+    if (view == nullptr)
+    {
+        fprintf(stderr, "Error: Mapping %s failed.\n", m_filePath.c_str());
+        return false;
+    }
+
+    m_mapping = view;
+    m_mappingSize = static_cast<size_t>(fileSize.QuadPart);
+#else
+    const int fd = open(m_filePath.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("Error");
+        return false;
+    }
+
+    struct stat status;
+    if (fstat(fd, &status) != 0)
+    {
+        perror("Error");
+        close(fd);
+        return false;
+    }
+
+    const size_t fileSize = static_cast<size_t>(status.st_size);
+    
+    // empty files cannot be mapped
+    if (fileSize == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    // shared read-only mappings are backed by the page cache and shared between processes
+    void * mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        perror("Error");
+        return false;
+    }
+
+    int advice = POSIX_MADV_NORMAL;
+    if (access == Access::MapSequential)
+        advice = POSIX_MADV_SEQUENTIAL;
+    else if (access == Access::MapRandom)
+        advice = POSIX_MADV_RANDOM;
+
+    posix_madvise(mapping, fileSize, advice);
+
+    m_mapping = mapping;
+    m_mappingSize = fileSize;
+#endif
+
+    // properties reference the header within the mapping
+    return readHeader(static_cast<const char *>(m_mapping), m_mappingSize, parseProperties);
+}
+
+inline void RawFile::unmapFile()
+{
+    if (!isMapped())
+        return;
+
+    if (!m_borrowed)
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_mapping);
+#else
+        munmap(m_mapping, m_mappingSize);
+#endif
+    }
+
+    m_mapping = nullptr;
+    m_mappingSize = 0;
+    m_dataOffset = 0;
+}
+
+inline bool RawFile::openFile()
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileA(m_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ
+        , nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Error: Opening %s failed.\n", m_filePath.c_str());
+        return false;
+    }
+
+    m_fileHandle = reinterpret_cast<intptr_t>(file);
+#else
+    const int fd = open(m_filePath.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        perror("Error");
+        return false;
+    }
+
+    m_fileHandle = fd;
+#endif
+
+    return true;
+}
+
+inline void RawFile::closeFile()
+{
+    if (m_fileHandle == -1)
+        return;
+
+#ifdef _WIN32
+    CloseHandle(reinterpret_cast<HANDLE>(m_fileHandle));
+#else
+    close(static_cast<int>(m_fileHandle));
+#endif
+
+    m_fileHandle = -1;
+}
+
+inline bool RawFile::readAt(uint64_t offset, char * buffer, size_t size) const
+{
+    // positioned reads leave no file position behind and may be issued concurrently
+    while (size > 0)
+    {
+#ifdef _WIN32
+        const DWORD chunk = static_cast<DWORD>(std::min<size_t>(size, 1u << 30));
+
+        OVERLAPPED overlapped = { };
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+
+        DWORD count = 0;
+        if (!ReadFile(reinterpret_cast<HANDLE>(m_fileHandle), buffer, chunk, &count, &overlapped) || count == 0)
+            return false;
+#else
+        const ssize_t count = pread(static_cast<int>(m_fileHandle), buffer, size, static_cast<off_t>(offset));
+
+        if (count < 0 && errno == EINTR)
+            continue;
+
+        if (count <= 0)
+            return false;
+#endif
+
+        buffer += count;
+        offset += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+inline bool RawFile::fileSize(uint64_t & size) const
+{
+#ifdef _WIN32
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(reinterpret_cast<HANDLE>(m_fileHandle), &fileSize))
+        return false;
+
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+#else
+    struct stat status;
+    if (fstat(static_cast<int>(m_fileHandle), &status) != 0)
+        return false;
+
+    size = static_cast<uint64_t>(status.st_size);
+#endif
+
+    return true;
+}
+
+inline const RawFile::Property * RawFile::findProperty(const std::string & key, PropertyType type) const
+{
+    // the last property not greater than key is the latest of all equal ones
+    auto it = std::upper_bound(m_properties.begin(), m_properties.end(), key, 
+        [type](const std::string & key, const Property & property)
+    {
+        const int result = detail::compareKeys(key.data(), key.size(), property.key, property.keyLength);
+        return result < 0 || (result == 0 && type < property.type);
+    });
+
+    if (it == m_properties.begin())
+        return nullptr;
+
+    --it;
+
+    if (it->type != type || detail::compareKeys(key.data(), key.size(), it->key, it->keyLength) != 0)
+        return nullptr;
+
+    return &*it;
+}
+
+} // namespace glraw
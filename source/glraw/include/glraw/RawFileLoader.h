@@ -0,0 +1,90 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glraw/glraw_api.h>
+#include <glraw/RawFile.h>
+
+
+namespace glraw
+{
+
+/** @brief
+ * Loads RawFiles asynchronously on a pool of worker threads.
+ *
+ * Requests are queued up to the configured queue depth; further calls to load()
+ * block until a worker takes a request, so large batches do not buffer without bound.
+ * Open, seek and read of independent files thus overlap instead of running serially
+ * on the calling thread.
+ */
+class GLRAW_API RawFileLoader
+{
+public:
+    /** Called once per requested path from a worker thread. file is nullptr
+        if loading failed; callbacks of one batch may run concurrently.
+    */
+    using Callback = std::function<void(const std::string & path, std::shared_ptr<RawFile> file)>;
+
+    /** \param threadCount Number of worker threads; 0 uses std::thread::hardware_concurrency().
+        \param queueDepth Number of requests that may wait for a worker.
+    */
+    RawFileLoader(int threadCount = 0, size_t queueDepth = 64);
+
+    /** Waits for all queued requests to complete.
+    */
+    ~RawFileLoader();
+
+    int threadCount() const;
+    size_t queueDepth() const;
+
+    /** \return Returns a future holding the loaded file, or nullptr if it is invalid.
+    */
+    std::future<std::shared_ptr<RawFile>> load(
+        const std::string & filePath,
+        bool parseProperties = true,
+        RawFile::Access access = RawFile::Access::Read);
+
+    /** Queues all paths and returns once they are queued, not loaded.
+    */
+    void load(
+        const std::vector<std::string> & filePaths,
+        const Callback & callback,
+        bool parseProperties = true,
+        RawFile::Access access = RawFile::Access::Read);
+
+    /** Blocks until all queued requests are completed.
+    */
+    void wait();
+
+protected:
+    void enqueue(std::function<void()> && task);
+    void work();
+
+protected:
+    size_t m_queueDepth;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskQueued;
+    std::condition_variable m_taskTaken;
+    std::condition_variable m_idle;
+
+    std::deque<std::function<void()>> m_tasks;
+    size_t m_pending;
+    bool m_stopped;
+
+    std::vector<std::thread> m_threads;
+
+private:
+    RawFileLoader(const RawFileLoader &) = delete;
+    RawFileLoader & operator=(const RawFileLoader &) = delete;
+};
+
+} // namespace glraw
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <functional>
+
+#include <QString>
+
+#include <glraw/glraw_api.h>
+#include <glraw/RawFile.h>
+
+
+namespace glraw
+{
+
+/** @brief
+ * Probes all .glraw files of a directory tree on multiple threads.
+ *
+ * By default only signature and properties of each file are read (see RawFile::Access::HeaderOnly),
+ * so cataloging large asset trees does not touch the raw data.
+ */
+class GLRAW_API RawFileScanner
+{
+public:
+    /** Called for every file, concurrently from all worker threads. Files that could
+        not be opened or parsed are passed as well, so that callers can report them
+        (see RawFile::isValid()).
+    */
+    using Callback = std::function<void(const RawFile & file)>;
+
+    RawFileScanner();
+    ~RawFileScanner();
+
+    int threadCount() const;
+    /** \param count Number of worker threads; 0 uses QThread::idealThreadCount().
+    */
+    void setThreadCount(int count);
+
+    bool recursive() const;
+    void setRecursive(bool b);
+
+    RawFile::Access access() const;
+    void setAccess(RawFile::Access access);
+
+    /** \return Returns the number of files passed to callback.
+    */
+    int scan(const QString & directory, const Callback & callback) const;
+
+protected:
+    int m_threadCount;
+    bool m_recursive;
+    RawFile::Access m_access;
+};
+
+} // namespace glraw
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include <glraw/RawFile.h>
+
+
+namespace glraw
+{
+
+/** @brief
+ * Reader for .glpack archives, which hold many .glraw files in one file.
+ *
+ * The archive is memory mapped once; entries are looked up by name with a binary
+ * search over the sorted table of contents and returned as views into the mapping.
+ * Like RawFile, the reader is header-only and depends on the standard library only.
+ *
+ * Layout (little endian): a 32 byte preamble (16 bit signature and version, 32 bit
+ * entry alignment, 64 bit entry count and table offset, reserved), the entries, each
+ * a complete .glraw file at an aligned offset, and the table of contents: one record
+ * per entry (name offset, name length, entry offset, entry size; 64 bit each) sorted
+ * by name, followed by the names.
+ */
+class RawPack
+{
+public:
+    static const uint16_t s_signature = 0xC6F6;
+    static const uint16_t s_version = 1;
+
+    static const size_t s_preambleSize = 32;
+    static const size_t s_recordSize = 32;
+
+    RawPack(const std::string & filePath);
+    virtual ~RawPack();
+
+    RawPack(const RawPack &) = delete;
+    RawPack & operator=(const RawPack &) = delete;
+
+    bool isValid() const;
+    const std::string & filePath() const;
+
+    /** \return Returns the number of entries.
+    */
+    size_t count() const;
+
+    /** \return Returns the name of the entry at index; entries are sorted by name.
+    */
+    std::string name(size_t index) const;
+
+    /** Looks up an entry in O(log n) without copying. Pass the view to RawFile(data, size, ...)
+        to access its properties and raw data.
+        \return Returns false if the archive contains no entry of the given name.
+    */
+    bool find(const std::string & name, const char *& data, size_t & size) const;
+
+    /** \return Returns the entry at index as in find().
+    */
+    bool entry(size_t index, const char *& data, size_t & size) const;
+
+protected:
+    bool readTableOfContents();
+    const char * record(size_t index) const;
+    bool contains(uint64_t offset, uint64_t length) const;
+
+protected:
+    RawFile m_file;
+
+    const char * m_records;
+    size_t m_count;
+
+    bool m_valid;
+
+};
+
+} // namespace glraw
+
+#include <glraw/RawPack.hpp>
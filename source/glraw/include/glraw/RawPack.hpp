@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace glraw
+{
+
+// a pack does not start with a .glraw signature, so the file maps as one headerless payload
+inline RawPack::RawPack(const std::string & filePath)
+: m_file(filePath, false, RawFile::Access::MapRandom)
+, m_records(nullptr)
+, m_count(0)
+, m_valid(false)
+{
+    m_valid = m_file.isValid() && readTableOfContents();
+}
+
+
+inline RawPack::~RawPack()
+{
+}
+
+
+inline bool RawPack::isValid() const
+{
+    return m_valid;
+}
+
+
+inline const std::string & RawPack::filePath() const
+{
+    return m_file.filePath();
+}
+
+
+inline size_t RawPack::count() const
+{
+    return m_count;
+}
+
+
+inline std::string RawPack::name(size_t index) const
+{
+    if (index >= m_count)
+        return std::string();
+
+    const char * r = record(index);
+    const uint64_t offset = detail::read<uint64_t>(r);
+    const uint64_t length = detail::read<uint64_t>(r + 8);
+
+    if (!contains(offset, length))
+        return std::string();
+
+    return std::string(m_file.data() + offset, static_cast<size_t>(length));
+}
+
+
+inline bool RawPack::find(const std::string & name, const char *& data, size_t & size) const
+{
+    size_t first = 0;
+    size_t last = m_count;
+
+    while (first < last)
+    {
+        const size_t middle = first + (last - first) / 2;
+        const char * r = record(middle);
+        const uint64_t offset = detail::read<uint64_t>(r);
+        const uint64_t length = detail::read<uint64_t>(r + 8);
+
+        if (!contains(offset, length))
+            return false;
+
+        const int result = detail::compareKeys(m_file.data() + offset
+            , static_cast<size_t>(length), name.data(), name.size());
+
+        if (result == 0)
+            return entry(middle, data, size);
+
+        if (result < 0)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return false;
+}
+
+
+inline bool RawPack::entry(size_t index, const char *& data, size_t & size) const
+{
+    if (index >= m_count)
+        return false;
+
+    const char * r = record(index);
+    const uint64_t offset = detail::read<uint64_t>(r + 16);
+    const uint64_t length = detail::read<uint64_t>(r + 24);
+
+    if (!contains(offset, length))
+        return false;
+
+    data = m_file.data() + offset;
+    size = static_cast<size_t>(length);
+
+    return true;
+}
+
+
+inline bool RawPack::readTableOfContents()
+{
+    const char * data = m_file.data();
+    const uint64_t size = m_file.size();
+
+    if (size < s_preambleSize
+        || detail::read<uint16_t>(data) != s_signature
+        || detail::read<uint16_t>(data + 2) != s_version)
+        return false;
+
+    const uint64_t count = detail::read<uint64_t>(data + 8);
+    const uint64_t tableOffset = detail::read<uint64_t>(data + 16);
+
+    if (tableOffset > size || count > (size - tableOffset) / s_recordSize)
+        return false;
+
+    m_records = data + tableOffset;
+    m_count = static_cast<size_t>(count);
+
+    return true;
+}
+
+
+// records are checked on access, so that opening does not page in the whole table
+inline bool RawPack::contains(uint64_t offset, uint64_t length) const
+{
+    const uint64_t size = m_file.size();
+
+    return offset <= size && length <= size - offset;
+}
+
+
+inline const char * RawPack::record(size_t index) const
+{
+    return m_records + index * s_recordSize;
+}
+
+} // namespace glraw
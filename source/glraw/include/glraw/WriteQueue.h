@@ -0,0 +1,76 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include <glraw/glraw_api.h>
+
+
+namespace glraw
+{
+
+/** @brief
+ * Runs writes in order on a dedicated writer thread.
+ *
+ * Each write is queued with the number of bytes it keeps alive until it completes.
+ * Once the bytes in flight exceed the budget, enqueue() blocks until enough writes
+ * completed, so a fast converter cannot buffer without bound while the disk lags.
+ * Failed writes are counted and reported by wait().
+ */
+class GLRAW_API WriteQueue
+{
+public:
+    using Write = std::function<bool()>;
+
+    /** \param byteBudget Bytes that may be in flight; a single larger write is still accepted.
+    */
+    WriteQueue(size_t byteBudget);
+
+    /** Waits for all queued writes to complete.
+    */
+    ~WriteQueue();
+
+    size_t byteBudget() const;
+
+    /** Queues write, blocking while the budget does not admit another size bytes.
+    */
+    void enqueue(size_t size, Write && write);
+
+    /** Blocks until all queued writes are completed.
+        \return Returns the number of writes that failed since the last call.
+    */
+    int wait();
+
+protected:
+    void work();
+
+protected:
+    struct Task
+    {
+        size_t size;
+        Write write;
+    };
+
+    size_t m_byteBudget;
+
+    std::mutex m_mutex;
+    std::condition_variable m_taskQueued;
+    std::condition_variable m_taskCompleted;
+
+    std::deque<Task> m_tasks;
+    size_t m_bytesInFlight;
+    size_t m_pending;
+    int m_failures;
+    bool m_stopped;
+
+    std::thread m_thread;
+
+private:
+    WriteQueue(const WriteQueue &) = delete;
+    WriteQueue & operator=(const WriteQueue &) = delete;
+};
+
+} // namespace glraw
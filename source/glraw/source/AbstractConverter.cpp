@@ -1,16 +1,30 @@
 
 #include <glraw/AbstractConverter.h>
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include <QDebug>
 #include <QFile>
 #include <QTextStream>
 
+#include <glraw/AssetInformation.h>
+#include <glraw/HDRImage.h>
+
 
 namespace glraw
 {
 
 AbstractConverter::AbstractConverter()
 :   m_fragmentShader("")
+,   m_normalMap(false)
+,   m_normalMapKernel(Canvas::NormalMapKernel::Sobel)
+,   m_normalMapStrength(1.f)
+,   m_normalMapWrapMode(Canvas::WrapMode::Clamp)
+,   m_normalMapSigned(false)
+,   m_tileSize(0)
+,   m_tileBorder(0)
 {
 }
 
@@ -18,6 +32,162 @@ AbstractConverter::~AbstractConverter()
 {
 }
 
+QByteArray AbstractConverter::convert(QImage & image, AssetInformation & info)
+{
+    QByteArray imageData;
+    convert(image, info, [&imageData](const QByteArray & data)
+    {
+        imageData = QByteArray(data.constData(), data.size());
+        return true;
+    });
+
+    return imageData;
+}
+
+QByteArray AbstractConverter::convert(const HDRImage & image, AssetInformation & info)
+{
+    QByteArray imageData;
+    convert(image, info, [&imageData](const QByteArray & data)
+    {
+        imageData = QByteArray(data.constData(), data.size());
+        return true;
+    });
+
+    return imageData;
+}
+
+bool AbstractConverter::convert(QImage & image, AssetInformation & info, const DataHandler & handler)
+{
+    m_canvas.loadTextureFromImage(image);
+
+    if (!processTexture())
+        return false;
+
+    return convertTexture(info, tilingHandler(info, handler));
+}
+
+bool AbstractConverter::convert(const HDRImage & image, AssetInformation & info, const DataHandler & handler)
+{
+    m_canvas.loadTextureFromImage(image);
+
+    if (!processTexture())
+        return false;
+
+    return convertTexture(info, tilingHandler(info, handler));
+}
+
+AbstractConverter::DataHandler AbstractConverter::tilingHandler(AssetInformation & info, const DataHandler & handler) const
+{
+    if (!hasTiling())
+        return handler;
+
+    // the tiles are arranged in client memory, reading the mapped data once
+    return [this, &info, handler](const QByteArray & imageData)
+    {
+        const QByteArray tiled = arrangeTiles(imageData, info);
+        return !tiled.isEmpty() && handler(tiled);
+    };
+}
+
+bool AbstractConverter::processTexture()
+{
+    if (hasFragmentShader() && !m_canvas.process(m_fragmentShader, m_uniforms))
+        return false;
+    
+    if (hasNormalMap() && !m_canvas.generateNormalMap(m_normalMapKernel
+        , m_normalMapStrength, m_normalMapWrapMode, m_normalMapSigned))
+        return false;
+
+    return true;
+}
+
+QByteArray AbstractConverter::arrangeTiles(const QByteArray & imageData, AssetInformation & info) const
+{
+    const int width = info.property("width").toInt();
+    const int height = info.property("height").toInt();
+
+    // compressed data is moved in blocks of 4x4 pixels, uncompressed data in pixels
+    const bool compressed = info.propertyExists("compressedFormat");
+    const int unitExtent = compressed ? 4 : 1;
+
+    if (m_tileSize % unitExtent != 0 || m_tileBorder % unitExtent != 0)
+    {
+        qDebug() << "Tile size and border have to be multiples of 4 for compressed formats.";
+        return QByteArray();
+    }
+
+    const int columns = (width + unitExtent - 1) / unitExtent;
+    const int rows = (height + unitExtent - 1) / unitExtent;
+
+    const qint64 units = static_cast<qint64>(columns) * rows;
+
+    if (units == 0 || imageData.size() % units != 0)
+    {
+        qDebug() << "Raw data does not match the image size.";
+        return QByteArray();
+    }
+
+    const int unitSize = static_cast<int>(imageData.size() / units);
+    const int tile = m_tileSize / unitExtent;
+    const int border = m_tileBorder / unitExtent;
+    const int paddedTile = tile + 2 * border;
+
+    const int tileColumns = (columns + tile - 1) / tile;
+    const int tileRows = (rows + tile - 1) / tile;
+    const qint64 tileBytes = static_cast<qint64>(paddedTile) * paddedTile * unitSize;
+    const qint64 tiledSize = static_cast<qint64>(tileColumns) * tileRows * tileBytes;
+
+    // tileBytes is stored as int property as well
+    if (tiledSize > std::numeric_limits<int>::max())
+    {
+        qDebug() << "Tiled raw data exceeds" << std::numeric_limits<int>::max() << "bytes.";
+        return QByteArray();
+    }
+
+    // edge tiles are padded to the full size, so that all tiles are equally large
+    QByteArray tiled(static_cast<int>(tiledSize), Qt::Uninitialized);
+
+    const char * source = imageData.constData();
+    char * target = tiled.data();
+
+    for (int tileRow = 0; tileRow < tileRows; ++tileRow)
+    {
+        for (int tileColumn = 0; tileColumn < tileColumns; ++tileColumn)
+        {
+            const int x0 = tileColumn * tile - border;
+            const int x1 = x0 + paddedTile;
+            const int inner0 = std::max(x0, 0);
+            const int inner1 = std::min(x1, columns);
+
+            for (int y = 0; y < paddedTile; ++y)
+            {
+                const int sourceRow = std::min(std::max(tileRow * tile - border + y, 0), rows - 1);
+                const char * row = source + static_cast<qint64>(sourceRow) * columns * unitSize;
+
+                for (int x = x0; x < inner0; ++x, target += unitSize)
+                    std::memcpy(target, row, unitSize);
+
+                std::memcpy(target, row + inner0 * unitSize, (inner1 - inner0) * unitSize);
+                target += (inner1 - inner0) * unitSize;
+
+                for (int x = inner1; x < x1; ++x, target += unitSize)
+                    std::memcpy(target, row + (columns - 1) * unitSize, unitSize);
+            }
+        }
+    }
+
+    info.setProperty("tileSize", m_tileSize);
+    info.setProperty("tileBorder", m_tileBorder);
+    info.setProperty("tileColumns", tileColumns);
+    info.setProperty("tileRows", tileRows);
+    info.setProperty("tileBytes", static_cast<int>(tileBytes));
+
+    if (compressed)
+        info.setProperty("size", tiled.size());
+
+    return tiled;
+}
+
 bool AbstractConverter::hasFragmentShader() const
 {
     return !m_fragmentShader.isEmpty();
@@ -57,4 +227,43 @@ bool AbstractConverter::setUniform(const QString & assignment)
     return true;
 }
 
+void AbstractConverter::setSRGB(bool enabled)
+{
+    m_canvas.setSRGB(enabled);
+}
+
+void AbstractConverter::setPremultiplyAlpha(bool enabled)
+{
+    m_canvas.setPremultiplyAlpha(enabled);
+}
+
+bool AbstractConverter::hasNormalMap() const
+{
+    return m_normalMap;
+}
+
+void AbstractConverter::setNormalMap(
+    Canvas::NormalMapKernel kernel
+,   float strength
+,   Canvas::WrapMode wrapMode
+,   bool signedOutput)
+{
+    m_normalMap = true;
+    m_normalMapKernel = kernel;
+    m_normalMapStrength = strength;
+    m_normalMapWrapMode = wrapMode;
+    m_normalMapSigned = signedOutput;
+}
+
+bool AbstractConverter::hasTiling() const
+{
+    return m_tileSize > 0;
+}
+
+void AbstractConverter::setTiling(int tileSize, int border)
+{
+    m_tileSize = tileSize;
+    m_tileBorder = border;
+}
+
 } // namespace glraw
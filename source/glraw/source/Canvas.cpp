@@ -2,6 +2,7 @@
 #include <glraw/Canvas.h>
 
 #include <cassert>
+#include <limits>
 
 #include <QGLWidget>
 #include <QtDebug>
@@ -11,6 +12,8 @@
 #include <QFile>
 #include <QOpenGLFunctions_3_2_Core>
 
+#include <glraw/HDRImage.h>
+
 #include "UniformParser.h"
 
 
@@ -28,6 +31,131 @@ namespace
         gl_Position = vec4(a_vertex * 1.0, 0.0, 1.0);
     }
     )";
+
+    // derives normals from the luminance of src using a 3x3 derivative kernel;
+    // texels are fetched explicitly so that the wrap mode applies per texel
+    const char * normalMapShaderSource =
+    R"(#version 150
+
+    uniform sampler2D src;
+
+    uniform int kernel;   // 0: sobel, 1: scharr
+    uniform int wrapMode; // 0: clamp, 1: repeat, 2: mirror
+    uniform int signedOutput;
+    uniform float strength;
+
+    in vec2 v_uv;
+    out vec4 dst;
+
+    // kernel offsets never exceed one texel, so texel is within [-1, size]
+    ivec2 wrap(ivec2 texel, ivec2 size)
+    {
+        if (wrapMode == 1)
+            return (texel + size) % size;
+
+        if (wrapMode == 2)
+            texel = size - 1 - abs(size - 1 - abs(texel));
+
+        return clamp(texel, ivec2(0), size - 1);
+    }
+
+    float height(ivec2 texel, ivec2 offset, ivec2 size)
+    {
+        vec3 color = texelFetch(src, wrap(texel + offset, size), 0).rgb;
+        return dot(color, vec3(0.2126, 0.7152, 0.0722));
+    }
+
+    void main()
+    {
+        ivec2 size = textureSize(src, 0);
+        ivec2 texel = ivec2(gl_FragCoord.xy);
+
+        float tl = height(texel, ivec2(-1, +1), size);
+        float t  = height(texel, ivec2( 0, +1), size);
+        float tr = height(texel, ivec2(+1, +1), size);
+        float l  = height(texel, ivec2(-1,  0), size);
+        float r  = height(texel, ivec2(+1,  0), size);
+        float bl = height(texel, ivec2(-1, -1), size);
+        float b  = height(texel, ivec2( 0, -1), size);
+        float br = height(texel, ivec2(+1, -1), size);
+
+        // outer and center weights, normalized to a per-texel derivative
+        vec2 weights = kernel == 1 ? vec2(3.0, 10.0) / 32.0 : vec2(1.0, 2.0) / 8.0;
+
+        float dx = weights.x * (tr + br - tl - bl) + weights.y * (r - l);
+        float dy = weights.x * (tl + tr - bl - br) + weights.y * (t - b);
+
+        vec3 normal = normalize(vec3(-dx * strength, -dy * strength, 1.0));
+
+        dst = vec4(signedOutput != 0 ? normal : normal * 0.5 + 0.5, 1.0);
+    }
+    )";
+
+    const char * premultiplyShaderSource =
+    R"(#version 150
+
+    uniform sampler2D src;
+
+    in vec2 v_uv;
+    out vec4 dst;
+
+    void main()
+    {
+        vec4 color = texture(src, v_uv);
+        dst = vec4(color.rgb * color.a, color.a);
+    }
+    )";
+
+    const char * decodeSRGBShaderSource =
+    R"(#version 150
+
+    uniform sampler2D src;
+
+    in vec2 v_uv;
+    out vec4 dst;
+
+    void main()
+    {
+        vec4 color = texture(src, v_uv);
+        vec3 linear = mix(color.rgb / 12.92, pow((color.rgb + 0.055) / 1.055, vec3(2.4))
+            , step(0.04045, color.rgb));
+
+        dst = vec4(linear, color.a);
+    }
+    )";
+
+    const char * encodeSRGBShaderSource =
+    R"(#version 150
+
+    uniform sampler2D src;
+
+    in vec2 v_uv;
+    out vec4 dst;
+
+    void main()
+    {
+        vec4 color = texture(src, v_uv);
+        vec3 linear = max(color.rgb, vec3(0.0));
+        vec3 encoded = mix(linear * 12.92, 1.055 * pow(linear, vec3(1.0 / 2.4)) - 0.055
+            , step(0.0031308, linear));
+
+        dst = vec4(encoded, color.a);
+    }
+    )";
+
+    const char * passThroughShaderSource =
+    R"(#version 150
+
+    uniform sampler2D src;
+
+    in vec2 v_uv;
+    out vec4 dst;
+
+    void main()
+    {
+        dst = texture(src, v_uv);
+    }
+    )";
 }
 
 namespace glraw
@@ -36,6 +164,9 @@ namespace glraw
 Canvas::Canvas()
 :   QWindow((QScreen *)nullptr)
 ,   m_texture(0)
+,   m_sRGB(false)
+,   m_premultiplyAlpha(false)
+,   m_sRGBDecoded(false)
 ,   m_gl(new QOpenGLFunctions_3_2_Core)
 {
     setSurfaceType(OpenGLSurface);
@@ -79,23 +210,101 @@ void Canvas::loadTextureFromImage(const QImage & image)
 {
     m_context.makeCurrent(this);
     
-    QImage glImage = QGLWidget::convertToGLFormat(image);
+    const bool highBitDepth = isHighBitDepth(image);
+
+    QImage glImage = highBitDepth ? convertToHighBitDepthGLFormat(image) 
+        : QGLWidget::convertToGLFormat(image);
+
+    GLenum internalFormat = m_sRGB ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    GLenum type = GL_UNSIGNED_BYTE;
+
+    // there is no 16 bit sRGB format, decoding is done in a separate pass
+    if (highBitDepth)
+    {
+        internalFormat = GL_RGBA16;
+        type = GL_UNSIGNED_SHORT;
+    }
     
     if (!textureLoaded())
         m_gl->glGenTextures(1, &m_texture);
     
     m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
-    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8
-        , glImage.width(), glImage.height(), 0, GL_RGBA, GL_UNSIGNED_BYTE, glImage.bits());
+    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat
+        , glImage.width(), glImage.height(), 0, GL_RGBA, type, glImage.bits());
     
     m_gl->glBindTexture(GL_TEXTURE_2D, 0);
     
     m_context.doneCurrent();
+
+    m_sRGBDecoded = false;
+
+    if (m_sRGB && highBitDepth)
+        process(decodeSRGBShaderSource, QMap<QString, QString>());
+
+    if (m_premultiplyAlpha)
+        process(premultiplyShaderSource, QMap<QString, QString>());
+}
+
+void Canvas::loadTextureFromImage(const HDRImage & image)
+{
+    m_context.makeCurrent(this);
+    
+    if (!textureLoaded())
+        m_gl->glGenTextures(1, &m_texture);
+    
+    m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
+    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F
+        , image.width(), image.height(), 0, GL_RGBA, GL_FLOAT, image.bits());
+    
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    
+    m_context.doneCurrent();
+
+    // hdr values are linear already and only need encoding for sRGB output
+    m_sRGBDecoded = m_sRGB;
+
+    if (m_premultiplyAlpha)
+        process(premultiplyShaderSource, QMap<QString, QString>());
 }
     
 QByteArray Canvas::imageFromTexture(GLenum format, GLenum type)
+{
+    QByteArray imageData;
+    imageFromTexture(format, type, [&imageData](const QByteArray & data)
+    {
+        imageData = QByteArray(data.constData(), data.size());
+        return true;
+    });
+
+    return imageData;
+}
+    
+QByteArray Canvas::compressedImageFromTexture(GLenum compressedInternalFormat)
+{
+    QByteArray compressedImageData;
+    compressedImageFromTexture(compressedInternalFormat, [&compressedImageData](const QByteArray & data)
+    {
+        compressedImageData = QByteArray(data.constData(), data.size());
+        return true;
+    });
+
+    return compressedImageData;
+}
+
+bool Canvas::imageFromTexture(GLenum format, GLenum type, const DataHandler & handler)
 {
     assert(textureLoaded());
+
+    const int pixelSize = byteSizeOfPixel(format, type);
+
+    if (pixelSize < 0)
+    {
+        qDebug() << "Packed type does not match the number of components of the format.";
+        return false;
+    }
+
+    if (m_sRGBDecoded)
+        encodeSRGB(type);
     
     m_context.makeCurrent(this);
     m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
@@ -104,20 +313,45 @@ QByteArray Canvas::imageFromTexture(GLenum format, GLenum type)
     m_gl->glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
     m_gl->glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
     
-    QByteArray imageData;
-    imageData.resize(numberOfElementsFor(format) * byteSizeOf(type) * width * height);
+    const qint64 size = static_cast<qint64>(pixelSize) * width * height;
+
+    // the handler receives the image as QByteArray, which is limited to int
+    if (size > std::numeric_limits<int>::max())
+    {
+        qDebug() << "Image of" << size << "bytes exceeds the maximum size of a QByteArray.";
+        m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+        m_context.doneCurrent();
+        return false;
+    }
+
+    GLuint pixelBuffer;
+    m_gl->glGenBuffers(1, &pixelBuffer);
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    m_gl->glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(size), nullptr, GL_STREAM_READ);
     
-    m_gl->glGetTexImage(GL_TEXTURE_2D, 0, format, type, imageData.data());
+    // rows are tightly packed, e.g., for GL_RGB or 16 bit packed types of odd width
+    m_gl->glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    m_gl->glGetTexImage(GL_TEXTURE_2D, 0, format, type, nullptr);
+    m_gl->glPixelStorei(GL_PACK_ALIGNMENT, 4);
     
     m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+
+    const bool success = mapPixelBuffer(size, handler);
+
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_gl->glDeleteBuffers(1, &pixelBuffer);
     m_context.doneCurrent();
     
-    return imageData;
+    return success;
 }
     
-QByteArray Canvas::compressedImageFromTexture(GLenum compressedInternalFormat)
+bool Canvas::compressedImageFromTexture(GLenum compressedInternalFormat, const DataHandler & handler)
 {
-    QByteArray uncompressedImageData = imageFromTexture(GL_RGBA, GL_UNSIGNED_BYTE);
+    assert(textureLoaded());
+
+    // compressors read floats, so encoding keeps the full precision
+    if (m_sRGBDecoded)
+        encodeSRGB(GL_FLOAT);
     
     m_context.makeCurrent(this);
     m_gl->glBindTexture(GL_TEXTURE_2D, m_texture);
@@ -126,27 +360,94 @@ QByteArray Canvas::compressedImageFromTexture(GLenum compressedInternalFormat)
     m_gl->glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_WIDTH, &width);
     m_gl->glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_HEIGHT, &height);
     
+    const qint64 stagingSize = static_cast<qint64>(4 * sizeof(GLfloat)) * width * height;
+
+    if (stagingSize > std::numeric_limits<GLsizeiptr>::max())
+    {
+        qDebug() << "Image of" << stagingSize << "bytes exceeds the maximum size of a pixel buffer.";
+        m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+        m_context.doneCurrent();
+        return false;
+    }
+
+    // the uncompressed image is staged in a pixel buffer and handed to the 
+    // compressor from there, so it never travels through client memory
+    GLuint pixelBuffer;
+    m_gl->glGenBuffers(1, &pixelBuffer);
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    m_gl->glBufferData(GL_PIXEL_PACK_BUFFER, static_cast<GLsizeiptr>(stagingSize), nullptr, GL_STREAM_COPY);
+    m_gl->glGetTexImage(GL_TEXTURE_2D, 0, GL_RGBA, GL_FLOAT, nullptr);
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    
     GLuint compressedTexture;
     m_gl->glGenTextures(1, &compressedTexture);
     m_gl->glBindTexture(GL_TEXTURE_2D, compressedTexture);
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
     m_gl->glTexImage2D(GL_TEXTURE_2D, 0, compressedInternalFormat, width, height, 0
-        , GL_RGBA, GL_UNSIGNED_BYTE, uncompressedImageData);
+        , GL_RGBA, GL_FLOAT, nullptr);
+    m_gl->glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     
     GLint size;
     m_gl->glGetTexLevelParameteriv(GL_TEXTURE_2D, 0, GL_TEXTURE_COMPRESSED_IMAGE_SIZE, &size);
     
-    QByteArray compressedImageData;
-    compressedImageData.resize(size);
-    m_gl->glGetCompressedTexImage(GL_TEXTURE_2D, 0, compressedImageData.data());
+    // the staging buffer takes the compressed image as well, which is smaller
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, pixelBuffer);
+    m_gl->glBufferData(GL_PIXEL_PACK_BUFFER, size, nullptr, GL_STREAM_READ);
+    m_gl->glGetCompressedTexImage(GL_TEXTURE_2D, 0, nullptr);
+    
+    m_gl->glBindTexture(GL_TEXTURE_2D, 0);
+    m_gl->glDeleteTextures(1, &compressedTexture);
+
+    const bool success = mapPixelBuffer(size, handler);
+
+    m_gl->glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    m_gl->glDeleteBuffers(1, &pixelBuffer);
     
     m_context.doneCurrent();
     
-    return compressedImageData;
+    return success;
+}
+
+bool Canvas::mapPixelBuffer(GLsizeiptr size, const DataHandler & handler)
+{
+    if (size < 0 || static_cast<qint64>(size) > std::numeric_limits<int>::max())
+    {
+        qDebug() << "Pixel buffer of" << size << "bytes cannot be held by a QByteArray.";
+        return false;
+    }
+
+    const void * data = m_gl->glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+
+    if (data == nullptr)
+    {
+        qDebug() << "Mapping the pixel buffer failed.";
+        return false;
+    }
+
+    // handler reads the mapping, which stays valid until it is unmapped
+    const bool success = handler(QByteArray::fromRawData(static_cast<const char *>(data), static_cast<int>(size)));
+
+    if (m_gl->glUnmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_FALSE)
+    {
+        // the buffer's content was lost meanwhile, e.g., due to a display mode change
+        qDebug() << "Pixel buffer got corrupted while mapped.";
+        return false;
+    }
+
+    return success;
 }
     
 bool Canvas::process(
     const QString & fragmentShader
 ,   const QMap<QString, QString> & uniforms)
+{
+    return process(fragmentShader, uniforms, GL_RGBA32F);
+}
+    
+bool Canvas::process(
+    const QString & fragmentShader
+,   const QMap<QString, QString> & uniforms
+,   GLenum internalFormat)
 {
     assert(textureLoaded());
     
@@ -182,7 +483,7 @@ bool Canvas::process(
     GLuint processedTexture;
     m_gl->glGenTextures(1, &processedTexture);
     m_gl->glBindTexture(GL_TEXTURE_2D, processedTexture);
-    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
+    m_gl->glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, GL_RGBA, GL_FLOAT, nullptr);
     
     GLuint fbo;
     m_gl->glGenFramebuffers(1, &fbo);
@@ -216,7 +517,16 @@ bool Canvas::process(
     
     program.setUniformValue("src", 0);
 
+    // linear values written to an sRGB target are encoded by the hardware
+    const bool sRGBTarget = internalFormat == GL_SRGB8_ALPHA8;
+
+    if (sRGBTarget)
+        m_gl->glEnable(GL_FRAMEBUFFER_SRGB);
+
     m_gl->glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    if (sRGBTarget)
+        m_gl->glDisable(GL_FRAMEBUFFER_SRGB);
     
     m_gl->glDeleteBuffers(1, &buffer);
     m_gl->glDeleteVertexArrays(1, &vao);
@@ -228,14 +538,101 @@ bool Canvas::process(
     m_context.doneCurrent();
 
     m_texture = processedTexture;
+    m_sRGBDecoded = m_sRGB && !sRGBTarget;
     
     return true;
 }
+
+void Canvas::encodeSRGB(GLenum type)
+{
+    // the 8 bit sRGB target is encoded by the hardware, but would quantize deeper types
+    if (type == GL_UNSIGNED_BYTE)
+        process(passThroughShaderSource, QMap<QString, QString>(), GL_SRGB8_ALPHA8);
+    else
+        process(encodeSRGBShaderSource, QMap<QString, QString>(), GL_RGBA32F);
+
+    m_sRGBDecoded = false;
+}
+    
+bool Canvas::generateNormalMap(
+    NormalMapKernel kernel
+,   float strength
+,   WrapMode wrapMode
+,   bool signedOutput)
+{
+    QMap<QString, QString> uniforms;
+    uniforms.insert("kernel", QString::number(kernel == NormalMapKernel::Scharr ? 1 : 0));
+    uniforms.insert("wrapMode", QString::number(static_cast<int>(wrapMode)));
+    uniforms.insert("signedOutput", QString::number(signedOutput ? 1 : 0));
+    uniforms.insert("strength", QString::number(strength));
+
+    if (!process(normalMapShaderSource, uniforms))
+        return false;
+
+    // normals are linear data, which must not be encoded to sRGB on readback
+    m_sRGBDecoded = false;
+
+    return true;
+}
+    
+bool Canvas::isHighBitDepth(const QImage & image)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    switch (image.format())
+    {
+        case QImage::Format_BGR30:
+        case QImage::Format_A2BGR30_Premultiplied:
+        case QImage::Format_RGB30:
+        case QImage::Format_A2RGB30_Premultiplied:
+        case QImage::Format_RGBX64:
+        case QImage::Format_RGBA64:
+        case QImage::Format_RGBA64_Premultiplied:
+#if QT_VERSION >= QT_VERSION_CHECK(5, 13, 0)
+        case QImage::Format_Grayscale16:
+#endif
+            return true;
+        default:
+            return false;
+    }
+#else
+    return false;
+#endif
+}
+
+QImage Canvas::convertToHighBitDepthGLFormat(const QImage & image)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 12, 0)
+    // rgba with 16 bit per channel, bottom row first
+    return image.convertToFormat(QImage::Format_RGBA64).mirrored();
+#else
+    return QGLWidget::convertToGLFormat(image);
+#endif
+}
     
 bool Canvas::textureLoaded() const
 {
     return m_texture != 0;
 }
+
+bool Canvas::sRGB() const
+{
+    return m_sRGB;
+}
+
+void Canvas::setSRGB(bool enabled)
+{
+    m_sRGB = enabled;
+}
+
+bool Canvas::premultiplyAlpha() const
+{
+    return m_premultiplyAlpha;
+}
+
+void Canvas::setPremultiplyAlpha(bool enabled)
+{
+    m_premultiplyAlpha = enabled;
+}
     
 int Canvas::byteSizeOf(GLenum type)
 {
@@ -247,18 +644,47 @@ int Canvas::byteSizeOf(GLenum type)
             break;
         case GL_UNSIGNED_SHORT:
         case GL_SHORT:
+        case GL_HALF_FLOAT:
             return sizeof(GLshort);
         case GL_UNSIGNED_INT:
         case GL_INT:
             return sizeof(GLint);
         case GL_FLOAT:
             return sizeof(GLfloat);
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+            return sizeof(GLushort);
+        case GL_UNSIGNED_INT_10_10_10_2:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+            return sizeof(GLuint);
         default:
             qFatal("Unsupported type passed.");
             return -1;
     }
 }
     
+int Canvas::byteSizeOfPixel(GLenum format, GLenum type)
+{
+    switch (type)
+    {
+        // packed types store all components of a pixel in a single value
+        case GL_UNSIGNED_SHORT_5_6_5:
+        case GL_UNSIGNED_INT_10F_11F_11F_REV:
+        case GL_UNSIGNED_INT_5_9_9_9_REV:
+            return format == GL_RGB ? byteSizeOf(type) : -1;
+        case GL_UNSIGNED_SHORT_4_4_4_4:
+        case GL_UNSIGNED_SHORT_5_5_5_1:
+        case GL_UNSIGNED_INT_10_10_10_2:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            return format == GL_RGBA || format == GL_BGRA ? byteSizeOf(type) : -1;
+        default:
+            return numberOfElementsFor(format) * byteSizeOf(type);
+    }
+}
+    
 int Canvas::numberOfElementsFor(GLenum format)
 {
     switch (format)
@@ -16,19 +16,21 @@ CompressionConverter::~CompressionConverter()
 {
 }
 
-QByteArray CompressionConverter::convert(QImage & image, AssetInformation & info)
+bool CompressionConverter::convertTexture(AssetInformation & info, const DataHandler & handler)
 {
-    m_canvas.loadTextureFromImage(image);
-    
-    if (hasFragmentShader() && !m_canvas.process(m_fragmentShader, m_uniforms))
-        return QByteArray();
-    
-    QByteArray imageData = m_canvas.compressedImageFromTexture(m_compressedFormat);
-    
     info.setProperty("compressedFormat", QVariant(static_cast<int>(m_compressedFormat)));
-    info.setProperty("size", QVariant(imageData.size()));
+
+    if (m_canvas.sRGB())
+        info.setProperty("sRGB", QVariant(1));
+    if (m_canvas.premultiplyAlpha())
+        info.setProperty("premultipliedAlpha", QVariant(1));
     
-    return imageData;
+    // the size is known once the driver compressed the image
+    return m_canvas.compressedImageFromTexture(m_compressedFormat, [&info, &handler](const QByteArray & imageData)
+    {
+        info.setProperty("size", QVariant(imageData.size()));
+        return handler(imageData);
+    });
 }
 
 void CompressionConverter::setCompressedFormat(GLint compressedFormat)
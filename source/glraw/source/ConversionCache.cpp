@@ -0,0 +1,243 @@
+
+#include <glraw/ConversionCache.h>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#   include <sys/types.h>
+#   include <sys/utime.h>
+#else
+#   include <stdio.h>
+#   include <sys/time.h>
+#endif
+
+#include <QDataStream>
+#include <QDebug>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTemporaryFile>
+
+#include <glraw/AssetInformation.h>
+#include <glraw/RawFile.h>
+
+
+namespace
+{
+
+const quint32 s_magic = 0x4343474C; // "GLCC"
+const quint32 s_version = 2;
+
+const QString s_suffix = ".glcache";
+
+// temporary files of crashed runs are removed once unmodified for this long, which
+// entries being written by other processes or machines never are
+const qint64 s_staleTemporarySeconds = 60 * 60;
+
+// marks the file as recently used for eviction
+bool touch(const QString & path)
+{
+#ifdef _WIN32
+    return _wutime(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(path).utf16()), nullptr) == 0;
+#else
+    return ::utimes(QFile::encodeName(path).constData(), nullptr) == 0;
+#endif
+}
+
+// unlike QFile::rename, an existing target is replaced atomically
+bool replaceFile(const QString & source, const QString & target)
+{
+#ifdef _WIN32
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16())
+        , reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(target).utf16())
+        , MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+
+}
+
+namespace glraw
+{
+
+ConversionCache::ConversionCache(const QString & directory, qint64 maximumSize)
+:   m_directory(directory)
+,   m_maximumSize(maximumSize)
+,   m_size(0)
+{
+    if (!QDir().mkpath(m_directory))
+        qDebug() << "Creating cache directory" << m_directory << "failed.";
+
+    evict();
+}
+
+ConversionCache::~ConversionCache()
+{
+}
+
+const QString & ConversionCache::directory() const
+{
+    return m_directory;
+}
+
+qint64 ConversionCache::maximumSize() const
+{
+    return m_maximumSize;
+}
+
+bool ConversionCache::load(const QString & key, QByteArray & imageData, AssetInformation & info)
+{
+    const QString path = entryPath(key);
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream dataStream(&file);
+    dataStream.setVersion(QDataStream::Qt_5_0);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    quint64 checksum = 0;
+    QVariantMap properties;
+
+    dataStream >> magic >> version;
+
+    if (magic != s_magic || version != s_version)
+        return false;
+
+    dataStream >> properties >> imageData >> checksum;
+
+    if (dataStream.status() != QDataStream::Ok || imageData.isEmpty()
+        || RawFile::checksum(imageData.constData(), imageData.size()) != checksum)
+    {
+        // removed, so that the next conversion stores a valid entry
+        qDebug() << "Cache entry" << path << "is corrupted.";
+        file.close();
+        QFile::remove(path);
+        imageData.clear();
+        return false;
+    }
+
+    for (auto it = properties.cbegin(); it != properties.cend(); ++it)
+        info.setProperty(it.key(), it.value());
+
+    touch(path);
+
+    return true;
+}
+
+bool ConversionCache::store(const QString & key, const QByteArray & imageData, const AssetInformation & info)
+{
+    const QString path = entryPath(key);
+
+    // created exclusively under a random name, since process ids repeat across machines sharing the cache
+    QTemporaryFile file(path + ".XXXXXX.tmp");
+
+    if (!file.open())
+    {
+        qDebug() << "Opening a temporary cache entry for" << path << "failed.";
+        return false;
+    }
+
+    const QString temporaryPath = file.fileName();
+
+    // temporary files are private by default, entries are read by other users as well
+    file.setPermissions(QFileDevice::ReadOwner | QFileDevice::WriteOwner
+        | QFileDevice::ReadGroup | QFileDevice::ReadOther);
+
+    QDataStream dataStream(&file);
+    dataStream.setVersion(QDataStream::Qt_5_0);
+
+    dataStream << s_magic << s_version << info.properties() << imageData
+        << static_cast<quint64>(RawFile::checksum(imageData.constData(), imageData.size()));
+
+    const qint64 size = file.size();
+    file.close();
+
+    // failed temporary files are removed with file
+    if (dataStream.status() != QDataStream::Ok || file.error() != QFileDevice::NoError)
+    {
+        qDebug() << "Writing cache entry" << temporaryPath << "failed.";
+        return false;
+    }
+
+    // replaces an entry another process stored meanwhile, so that readers always find one of both
+    if (!replaceFile(temporaryPath, path))
+    {
+        qDebug() << "Renaming cache entry" << temporaryPath << "failed.";
+        return false;
+    }
+
+    file.setAutoRemove(false);
+
+    m_size += size;
+
+    if (m_size > m_maximumSize)
+        evict();
+
+    return true;
+}
+
+void ConversionCache::evict()
+{
+    const QDir directory(m_directory);
+
+    // other processes may have stored or evicted entries, so all of them are counted anew
+    QFileInfoList entries = directory.entryInfoList(QStringList() << "*" + s_suffix, QDir::Files);
+
+    m_size = 0;
+    for (const QFileInfo & entry : entries)
+        m_size += entry.size();
+
+    // temporary files being written count as well, those left by crashed runs are removed
+    const QDateTime staleTime = QDateTime::currentDateTime().addSecs(-s_staleTemporarySeconds);
+
+    for (const QFileInfo & temporary : directory.entryInfoList(QStringList() << "*" + s_suffix + ".*.tmp", QDir::Files))
+    {
+        if (temporary.lastModified() < staleTime && QFile::remove(temporary.absoluteFilePath()))
+            continue;
+
+        m_size += temporary.size();
+    }
+
+    if (m_size <= m_maximumSize)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const QFileInfo & a, const QFileInfo & b)
+    {
+        return a.lastModified() < b.lastModified();
+    });
+
+    int count = 0;
+
+    for (const QFileInfo & entry : entries)
+    {
+        if (m_size <= m_maximumSize)
+            break;
+
+        if (!QFile::remove(entry.absoluteFilePath()))
+            continue;
+
+        m_size -= entry.size();
+        ++count;
+    }
+
+    qDebug() << count << "cache entries evicted.";
+}
+
+QString ConversionCache::entryPath(const QString & key) const
+{
+    return m_directory + "/" + key + s_suffix;
+}
+
+} // namespace glraw
@@ -2,24 +2,109 @@
 #include <glraw/ConvertManager.h>
 
 #include <cassert>
+#include <limits>
 
 #include <QDebug>
 #include <QFile>
+#include <QFileInfo>
 #include <QImage>
+#include <QVector>
 #include <QDataStream>
+#include <QtEndian>
 
 #include <glraw/AssetInformation.h>
 #include <glraw/ImageEditorInterface.h>
 #include <glraw/FileWriter.h>
 #include <glraw/AbstractConverter.h>
+#include <glraw/ConversionCache.h>
+#include <glraw/HDRImage.h>
+#include <glraw/RawFile.h>
+#include <glraw/WriteQueue.h>
 
 
+namespace
+{
+
+// unlike QIODevice::read, reads from pipes until size bytes arrived or the input ended
+bool readFully(QIODevice & device, char * data, qint64 size)
+{
+    while (size > 0)
+    {
+        const qint64 count = device.read(data, size);
+
+        // files block in read(), sockets and processes need to wait for more data
+        if (count == 0 && device.waitForReadyRead(-1))
+            continue;
+
+        if (count <= 0)
+            return false;
+
+        data += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+// hex digits of the XXH64 hash of the file's content, or an empty string if it cannot be read
+QString hashFile(const QString & path)
+{
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    quint64 hash;
+
+    // mapping spares copying the whole file, reading is the fallback, e.g., for empty files
+    if (const uchar * data = file.map(0, file.size()))
+        hash = glraw::RawFile::checksum(reinterpret_cast<const char *>(data), static_cast<size_t>(file.size()));
+    else
+    {
+        const QByteArray content = file.readAll();
+        hash = glraw::RawFile::checksum(content.constData(), content.size());
+    }
+
+    return QString::number(hash, 16).rightJustified(16, '0');
+}
+
+quint64 hashPixels(const QImage & image)
+{
+    // lines are hashed separately, since their padding is undefined
+    const size_t lineSize = (static_cast<size_t>(image.width()) * image.depth() + 7) / 8;
+
+    QVector<quint64> hashes;
+    hashes << static_cast<quint64>(image.width()) << static_cast<quint64>(image.height())
+        << static_cast<quint64>(image.format());
+
+    for (int y = 0; y < image.height(); ++y)
+        hashes << glraw::RawFile::checksum(reinterpret_cast<const char *>(image.constScanLine(y)), lineSize);
+
+    const QVector<QRgb> colorTable = image.colorTable();
+    hashes << glraw::RawFile::checksum(reinterpret_cast<const char *>(colorTable.constData()), colorTable.size() * sizeof(QRgb));
+
+    return glraw::RawFile::checksum(reinterpret_cast<const char *>(hashes.constData()), hashes.size() * sizeof(quint64));
+}
+
+quint64 hashPixels(const glraw::HDRImage & image)
+{
+    const quint64 hashes[] = { static_cast<quint64>(image.width()), static_cast<quint64>(image.height())
+        , glraw::RawFile::checksum(reinterpret_cast<const char *>(image.bits())
+            , static_cast<size_t>(image.width()) * image.height() * 4 * sizeof(float)) };
+
+    return glraw::RawFile::checksum(reinterpret_cast<const char *>(hashes), sizeof(hashes));
+}
+
+}
+
 namespace glraw
 {
 
 ConvertManager::ConvertManager(FileWriter * writer, AbstractConverter * converter)
 :   m_writer(writer)
 ,   m_converter(converter)
+,   m_incremental(false)
+,   m_deduplicate(false)
 {
 }
     
@@ -39,26 +124,222 @@ bool ConvertManager::process(const QString & sourcePath)
         return false;
     }
     
-    QImage image(sourcePath);
+    AssetInformation info;
+    QString cacheKey;
+
+    if (!m_fingerprint.isEmpty())
+    {
+        const QString sourceHash = hashFile(sourcePath);
+
+        info.setProperty("fingerprint", m_fingerprint);
+        info.setProperty("sourceHash", sourceHash);
+
+        if (m_incremental && !sourceHash.isEmpty() && m_writer->isUpToDate(sourcePath, info))
+        {
+            qDebug() << qPrintable(QFileInfo(sourcePath).fileName()) << "is up to date.";
+            return true;
+        }
+
+        if (!m_cache.isNull() && !sourceHash.isEmpty())
+            cacheKey = sourceHash + (m_conversionFingerprint.isEmpty() ? m_fingerprint : m_conversionFingerprint);
+
+        QByteArray imageData;
+
+        if (!cacheKey.isEmpty() && m_cache->load(cacheKey, imageData, info))
+        {
+            // the entry may stem from a run with other writer settings
+            info.setProperty("fingerprint", m_fingerprint);
+
+            qDebug() << qPrintable(QFileInfo(sourcePath).fileName()) << "taken from the cache.";
+            return write(imageData, sourcePath, info);
+        }
+    }
+
+    auto handler = [&](const QByteArray & imageData)
+    {
+        if (!cacheKey.isEmpty())
+            m_cache->store(cacheKey, imageData, info);
+
+        return write(imageData, sourcePath, info);
+    };
+
+    const bool hdr = HDRImage::canRead(sourcePath);
+
+    HDRImage hdrImage;
+    QImage image;
+
+    if (hdr)
+        hdrImage.load(sourcePath);
+    else
+        image.load(sourcePath);
+
+    // decoded pixels are compared, so that differently encoded sources match as well
+    QString pixelKey;
+
+    if (m_deduplicate && !m_incremental && !m_writer->standardOutput()
+        && !(hdr ? hdrImage.isNull() : image.isNull()))
+    {
+        const quint64 pixelHash = hdr ? hashPixels(hdrImage) : hashPixels(image);
+        pixelKey = QString::number(pixelHash, 16).rightJustified(16, '0') + m_fingerprint;
+    }
+
+    if (m_originals.contains(pixelKey))
+    {
+        const Original & original = m_originals[pixelKey];
+
+        qDebug() << qPrintable(QFileInfo(sourcePath).fileName()) << "duplicates"
+            << qPrintable(QFileInfo(original.sourcePath).fileName()) << ".";
+
+        return writeDuplicate(sourcePath, original.sourcePath, original.info);
+    }
+
+    const bool converted = hdr ? convertHDRImage(hdrImage, info, handler) : convertImage(image, info, handler);
+
+    if (converted && !pixelKey.isEmpty())
+        m_originals.insert(pixelKey, { sourcePath, info });
+
+    return converted;
+}
+
+bool ConvertManager::processData(const QByteArray & encodedImage, const QString & name)
+{
+    assert(!m_converter.isNull());
+    assert(!m_writer.isNull());
+
+    AssetInformation info;
+
+    auto handler = [&](const QByteArray & imageData)
+    {
+        return write(imageData, name, info);
+    };
+
+    if (HDRImage::canReadData(encodedImage))
+    {
+        HDRImage image;
+        image.loadFromData(encodedImage);
+        return convertHDRImage(image, info, handler);
+    }
+
+    QImage image = QImage::fromData(encodedImage);
+    return convertImage(image, info, handler);
+}
+
+int ConvertManager::processStream(QIODevice & input)
+{
+    int count = 0;
+
+    for (int index = 0; ; ++index)
+    {
+        quint64 size = 0;
+
+        if (!readFully(input, reinterpret_cast<char *>(&size), sizeof(size)))
+            break;
+
+        size = qFromLittleEndian(size);
+
+        // QByteArray cannot hold more
+        if (size > static_cast<quint64>(std::numeric_limits<int>::max()))
+        {
+            qDebug() << "Frame" << index << "exceeds the maximum image size.";
+            break;
+        }
+
+        QByteArray encodedImage(static_cast<int>(size), Qt::Uninitialized);
+
+        if (!readFully(input, encodedImage.data(), encodedImage.size()))
+        {
+            qDebug() << "Input ended within frame" << index << ".";
+            break;
+        }
+
+        if (processData(encodedImage, QString("frame%1").arg(index)))
+            ++count;
+        else if (!writeEmptyFrame())
+            break;
+    }
+
+    return count;
+}
+
+bool ConvertManager::convertImage(QImage & image, AssetInformation & info
+    , const AbstractConverter::DataHandler & handler)
+{
     if (image.isNull())
     {
-        qDebug() << "Loading image from input file failed.";
+        qDebug() << "Loading input image failed.";
         return false;
     }
 
-    AssetInformation info;
     info.setProperty("width", image.width());
     info.setProperty("height", image.height());
 
     for (auto editor : m_editors)
         editor->editImage(image, info);
 
-    QByteArray imageData = m_converter->convert(image, info);
+    return m_converter->convert(image, info, handler);
+}
 
-    if (imageData.isEmpty())
+bool ConvertManager::convertHDRImage(const HDRImage & image, AssetInformation & info
+    , const AbstractConverter::DataHandler & handler)
+{
+    if (image.isNull())
+    {
+        qDebug() << "Loading input image failed.";
         return false;
-    
-    m_writer->write(imageData, sourcePath, info);
+    }
+
+    info.setProperty("width", image.width());
+    info.setProperty("height", image.height());
+
+    // editors operate on QImage, which cannot hold hdr data
+    if (!m_editors.isEmpty())
+        qWarning() << "Image editors are not applied to HDR images.";
+
+    return m_converter->convert(image, info, handler);
+}
+
+bool ConvertManager::write(const QByteArray & imageData, const QString & name, AssetInformation & info)
+{
+    if (m_writeQueue.isNull())
+        return m_writer->write(imageData, name, info);
+
+    // imageData may borrow a mapped pixel buffer that is released once the converter
+    // returns, so queued writes own a copy
+    const QByteArray data(imageData.constData(), imageData.size());
+
+    FileWriter * writer = m_writer.data();
+    m_writeQueue->enqueue(data.size(), [writer, data, name, info]() mutable
+    {
+        return writer->write(data, name, info);
+    });
+
+    return true;
+}
+
+bool ConvertManager::writeDuplicate(const QString & sourcePath,
+    const QString & originalSourcePath, const AssetInformation & info)
+{
+    if (m_writeQueue.isNull())
+        return m_writer->writeDuplicate(sourcePath, originalSourcePath, info);
+
+    // queued as well, so that the original is written first
+    FileWriter * writer = m_writer.data();
+    m_writeQueue->enqueue(0, [writer, sourcePath, originalSourcePath, info]()
+    {
+        return writer->writeDuplicate(sourcePath, originalSourcePath, info);
+    });
+
+    return true;
+}
+
+bool ConvertManager::writeEmptyFrame()
+{
+    if (m_writeQueue.isNull())
+        return m_writer->writeEmptyFrame();
+
+    // queued as well, to keep its place among the frames
+    FileWriter * writer = m_writer.data();
+    m_writeQueue->enqueue(0, [writer]() { return writer->writeEmptyFrame(); });
 
     return true;
 }
@@ -70,6 +351,7 @@ void ConvertManager::appendImageEditor(ImageEditorInterface * editor)
     
 void ConvertManager::setWriter(FileWriter * writer)
 {
+    waitForWrites();
     m_writer.reset(writer);
 }
     
@@ -78,4 +360,73 @@ void ConvertManager::setConverter(AbstractConverter * converter)
     m_converter.reset(converter);
 }
 
+void ConvertManager::setFingerprint(const QString & fingerprint)
+{
+    m_fingerprint = fingerprint;
+}
+
+const QString & ConvertManager::fingerprint() const
+{
+    return m_fingerprint;
+}
+
+void ConvertManager::setConversionFingerprint(const QString & fingerprint)
+{
+    m_conversionFingerprint = fingerprint;
+}
+
+const QString & ConvertManager::conversionFingerprint() const
+{
+    return m_conversionFingerprint;
+}
+
+void ConvertManager::setIncremental(bool b)
+{
+    m_incremental = b;
+}
+
+bool ConvertManager::incremental() const
+{
+    return m_incremental;
+}
+
+void ConvertManager::setCache(ConversionCache * cache)
+{
+    m_cache.reset(cache);
+}
+
+void ConvertManager::setDeduplicate(bool b)
+{
+    m_deduplicate = b;
+    m_originals.clear();
+}
+
+bool ConvertManager::deduplicate() const
+{
+    return m_deduplicate;
+}
+
+void ConvertManager::setWriteBudget(size_t bytes)
+{
+    waitForWrites();
+
+    if (bytes == 0)
+        m_writeQueue.reset();
+    else
+        m_writeQueue.reset(new WriteQueue(bytes));
+}
+
+size_t ConvertManager::writeBudget() const
+{
+    return m_writeQueue.isNull() ? 0 : m_writeQueue->byteBudget();
+}
+
+int ConvertManager::waitForWrites()
+{
+    if (m_writeQueue.isNull())
+        return 0;
+
+    return m_writeQueue->wait();
+}
+
 } // namespace glraw
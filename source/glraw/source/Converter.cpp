@@ -17,17 +17,17 @@ Converter::~Converter()
 {
 }
 
-QByteArray Converter::convert(QImage & image, AssetInformation & info)
+bool Converter::convertTexture(AssetInformation & info, const DataHandler & handler)
 {
-    m_canvas.loadTextureFromImage(image);
-    
-    if (hasFragmentShader() && !m_canvas.process(m_fragmentShader, m_uniforms))
-        return QByteArray();
-    
     info.setProperty("format", QVariant(static_cast<int>(m_format)));
     info.setProperty("type", QVariant(static_cast<int>(m_type)));
+
+    if (m_canvas.sRGB())
+        info.setProperty("sRGB", QVariant(1));
+    if (m_canvas.premultiplyAlpha())
+        info.setProperty("premultipliedAlpha", QVariant(1));
     
-    return m_canvas.imageFromTexture(m_format, m_type);
+    return m_canvas.imageFromTexture(m_format, m_type, handler);
 }
 
 void Converter::setFormat(GLenum format)
@@ -31,7 +31,16 @@ namespace
 		{ GL_SHORT,          "s"  },
 		{ GL_UNSIGNED_INT,   "ui" },
 		{ GL_INT,            "i"  },
-		{ GL_FLOAT,          "f"  }
+		{ GL_FLOAT,          "f"  },
+		{ GL_HALF_FLOAT,     "hf" },
+
+		{ GL_UNSIGNED_SHORT_5_6_5,         "us565"          },
+		{ GL_UNSIGNED_SHORT_4_4_4_4,       "us4444"         },
+		{ GL_UNSIGNED_SHORT_5_5_5_1,       "us5551"         },
+		{ GL_UNSIGNED_INT_10_10_10_2,      "ui1010102"      },
+		{ GL_UNSIGNED_INT_2_10_10_10_REV,  "ui2101010rev"   },
+		{ GL_UNSIGNED_INT_10F_11F_11F_REV, "ui10f11f11frev" },
+		{ GL_UNSIGNED_INT_5_9_9_9_REV,     "ui5999rev"      }
 
 	#ifdef GL_ARB_texture_compression_rgtc
 		,
@@ -44,7 +53,8 @@ namespace
 		,
 		{ GL_COMPRESSED_RGBA_BPTC_UNORM_ARB,         "bptc-rgba-unorm" },
 		{ GL_COMPRESSED_RGB_BPTC_SIGNED_FLOAT_ARB,   "bptc-rgb-sf"     },
-		{ GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB, "bptc-rgb-uf"     }
+		{ GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT_ARB, "bptc-rgb-uf"     },
+		{ GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM_ARB,   "bptc-srgba-unorm" }
 	#endif
 	#ifdef GLRAW_DXT // special treatment here - see S3TCExtensions.h
 		,
@@ -53,6 +63,13 @@ namespace
 		{ GL_COMPRESSED_RGBA_S3TC_DXT3_EXT, "dxt3-rgba" },
 		{ GL_COMPRESSED_RGBA_S3TC_DXT5_EXT, "dxt5-rgba" }
 	#endif
+	#if defined(GLRAW_DXT) && defined(GL_EXT_texture_sRGB)
+		,
+		{ GL_COMPRESSED_SRGB_S3TC_DXT1_EXT,       "dxt1-srgb"  },
+		{ GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT1_EXT, "dxt1-srgba" },
+		{ GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT3_EXT, "dxt3-srgba" },
+		{ GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT, "dxt5-srgba" }
+	#endif
 	};
 }
 
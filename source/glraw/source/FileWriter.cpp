@@ -1,8 +1,37 @@
 
 #include <glraw/FileWriter.h>
 
+#include <algorithm>
+#include <atomic>
+#include <initializer_list>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#   ifndef WIN32_LEAN_AND_MEAN
+#       define WIN32_LEAN_AND_MEAN
+#   endif
+#   ifndef NOMINMAX
+#       define NOMINMAX
+#   endif
+#   include <windows.h>
+#   include <fcntl.h>
+#   include <io.h>
+#else
+#   include <errno.h>
+#   include <fcntl.h>
+#   include <stdlib.h>
+#   include <string.h>
+#   include <unistd.h>
+#   include <sys/uio.h>
+#endif
+
+#include <QCoreApplication>
 #include <QDebug>
 #include <QByteArray>
+#include <QDir>
+#include <QSet>
 #include <QString>
 #include <QFile>
 #include <QDataStream>
@@ -10,7 +39,353 @@
 
 #include <glraw/AssetInformation.h>
 #include <glraw/FileNameSuffix.h>
+#include <glraw/LZ4.h>
+#include <glraw/RawPack.h>
+
+
+namespace
+{
+
+/** Writes all parts with as few system calls as possible: one writev on POSIX,
+    which also works on pipes, since nothing needs to be seeked.
+*/
+bool writeAll(QFileDevice & file, std::initializer_list<QByteArray> parts)
+{
+#ifdef _WIN32
+    for (const QByteArray & part : parts)
+    {
+        if (file.write(part) != part.size())
+            return false;
+    }
+
+    return true;
+#else
+    iovec vectors[8];
+    int count = 0;
+
+    for (const QByteArray & part : parts)
+    {
+        if (part.isEmpty())
+            continue;
+
+        vectors[count].iov_base = const_cast<char *>(part.constData());
+        vectors[count].iov_len = static_cast<size_t>(part.size());
+        ++count;
+    }
+
+    iovec * vector = vectors;
+
+    while (count > 0)
+    {
+        const ssize_t written = ::writev(file.handle(), vector, count);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+
+        if (written <= 0)
+            return false;
+
+        // skip what was written, which may end within a part
+        size_t remaining = static_cast<size_t>(written);
+
+        while (count > 0 && remaining >= vector->iov_len)
+        {
+            remaining -= vector->iov_len;
+            ++vector;
+            --count;
+        }
+
+        if (count > 0)
+        {
+            vector->iov_base = static_cast<char *>(vector->iov_base) + remaining;
+            vector->iov_len -= remaining;
+        }
+    }
+
+    return true;
+#endif
+}
+
+const size_t s_directAlignment = 4096;              // covers the logical block size of all devices
+const size_t s_directBufferSize = 8 * 1024 * 1024;
+
+// bypasses the page cache for further writes to file, fails if the file system does not support it
+bool enableDirectWriting(QFileDevice & file)
+{
+#if defined(O_DIRECT)
+    const int flags = ::fcntl(file.handle(), F_GETFL);
+    return flags >= 0 && ::fcntl(file.handle(), F_SETFL, flags | O_DIRECT) == 0;
+#elif defined(F_NOCACHE)
+    return ::fcntl(file.handle(), F_NOCACHE, 1) != -1;
+#else
+    return false;
+#endif
+}
+
+#ifdef O_DIRECT
+bool writeFully(int handle, const char * data, size_t size)
+{
+    while (size > 0)
+    {
+        const ssize_t written = ::write(handle, data, size);
+
+        if (written < 0 && errno == EINTR)
+            continue;
+
+        if (written <= 0)
+            return false;
+
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+
+    return true;
+}
+#endif
+
+/** Writes all parts to a file after enableDirectWriting(). O_DIRECT requires aligned
+    addresses, sizes and file offsets, so parts are streamed through an aligned buffer,
+    while aligned runs of parts that start at an aligned file offset are written in place.
+    The last block is padded with zeros, which are truncated afterwards.
+*/
+bool writeDirect(QFileDevice & file, std::initializer_list<QByteArray> parts)
+{
+#ifdef O_DIRECT
+    void * memory = nullptr;
+    if (::posix_memalign(&memory, s_directAlignment, s_directBufferSize) != 0)
+        return false;
+
+    const std::unique_ptr<char, void (*)(void *)> buffer(static_cast<char *>(memory), &::free);
+    const int handle = file.handle();
+
+    size_t buffered = 0;
+    quint64 size = 0;
+
+    for (const QByteArray & part : parts)
+    {
+        const char * data = part.constData();
+        size_t remaining = static_cast<size_t>(part.size());
+        size += remaining;
+
+        while (remaining > 0)
+        {
+            if (buffered % s_directAlignment == 0 && remaining >= s_directAlignment
+                && reinterpret_cast<uintptr_t>(data) % s_directAlignment == 0)
+            {
+                const size_t length = remaining / s_directAlignment * s_directAlignment;
+
+                if (buffered > 0 && !writeFully(handle, buffer.get(), buffered))
+                    return false;
+
+                if (!writeFully(handle, data, length))
+                    return false;
+
+                buffered = 0;
+                data += length;
+                remaining -= length;
+                continue;
+            }
+
+            const size_t length = std::min(remaining, s_directBufferSize - buffered);
+            ::memcpy(buffer.get() + buffered, data, length);
+
+            buffered += length;
+            data += length;
+            remaining -= length;
+
+            if (buffered == s_directBufferSize)
+            {
+                if (!writeFully(handle, buffer.get(), buffered))
+                    return false;
+
+                buffered = 0;
+            }
+        }
+    }
+
+    if (buffered > 0)
+    {
+        const size_t padded = (buffered + s_directAlignment - 1) / s_directAlignment * s_directAlignment;
+        ::memset(buffer.get() + buffered, 0, padded - buffered);
+
+        if (!writeFully(handle, buffer.get(), padded))
+            return false;
+    }
+
+    return ::ftruncate(handle, static_cast<off_t>(size)) == 0;
+#else
+    // F_NOCACHE has no alignment requirements
+    return writeAll(file, parts);
+#endif
+}
+
+bool syncFile(QFileDevice & file)
+{
+#ifdef _WIN32
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(file.handle()))) != 0;
+#else
+    return ::fsync(file.handle()) == 0;
+#endif
+}
+
+// syncing a directory persists the renames within it
+bool syncDirectory(const QString & path)
+{
+#ifdef _WIN32
+    // NTFS journals renames without an explicit flush of the directory
+    return true;
+#else
+    const int fd = ::open(QFile::encodeName(path).constData(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    const bool success = ::fsync(fd) == 0;
+    ::close(fd);
+
+    return success;
+#endif
+}
+
+bool syncPaths(const QStringList & paths)
+{
+#ifdef _WIN32
+    for (const QString & path : paths)
+    {
+        QFile file(path);
+
+        if (!file.open(QIODevice::ReadWrite) || !syncFile(file))
+            return false;
+    }
+
+    return true;
+#else
+    // only the given files are synced, so that writeback of other processes does not stall the group
+    std::vector<int> handles;
+    bool success = true;
+
+    for (const QString & path : paths)
+    {
+        const int fd = ::open(QFile::encodeName(path).constData(), O_WRONLY);
+
+        if (fd < 0)
+            success = false;
+        else
+            handles.push_back(fd);
+    }
+
+#ifdef __linux__
+    // starting writeback of all files first lets the device work on them together
+    for (const int fd : handles)
+        ::sync_file_range(fd, 0, 0, SYNC_FILE_RANGE_WRITE);
+
+    for (const int fd : handles)
+        success = ::fdatasync(fd) == 0 && success;
+#else
+    for (const int fd : handles)
+        success = ::fsync(fd) == 0 && success;
+#endif
+
+    for (const int fd : handles)
+        ::close(fd);
 
+    return success;
+#endif
+}
+
+// unlike QFile::rename, an existing target is replaced atomically
+bool replaceFile(const QString & source, const QString & target)
+{
+#ifdef _WIN32
+    return MoveFileExW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16())
+        , reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(target).utf16())
+        , MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return ::rename(QFile::encodeName(source).constData(), QFile::encodeName(target).constData()) == 0;
+#endif
+}
+
+bool linkFile(const QString & source, const QString & link)
+{
+#ifdef _WIN32
+    return CreateHardLinkW(reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(link).utf16())
+        , reinterpret_cast<const wchar_t *>(QDir::toNativeSeparators(source).utf16()), nullptr) != 0;
+#else
+    return ::link(QFile::encodeName(source).constData(), QFile::encodeName(link).constData()) == 0;
+#endif
+}
+
+QString temporaryFilePath(const QString & path)
+{
+    return path + "." + QString::number(QCoreApplication::applicationPid()) + ".tmp";
+}
+
+const int s_compressionChunkSize = 1 << 20;
+
+// chunked as described in lz4.h, one chunk per task on all cores
+QByteArray compressChunks(const QByteArray & data)
+{
+    const size_t size = static_cast<size_t>(data.size());
+    const size_t chunkSize = s_compressionChunkSize;
+    const quint32 chunkCount = static_cast<quint32>((size + chunkSize - 1) / chunkSize);
+
+    std::vector<std::vector<char>> chunks(chunkCount);
+    std::atomic<quint32> next(0);
+
+    auto work = [&]()
+    {
+        for (quint32 i = next++; i < chunkCount; i = next++)
+        {
+            const size_t begin = i * chunkSize;
+            const size_t length = std::min(chunkSize, size - begin);
+
+            std::vector<char> & chunk = chunks[i];
+            chunk.resize(glraw::lz4::compressBound(length));
+            chunk.resize(glraw::lz4::compress(data.constData() + begin, length, chunk.data()));
+        }
+    };
+
+    const quint32 threadCount = std::min(chunkCount, std::max(1u, std::thread::hardware_concurrency()));
+
+    std::vector<std::thread> threads;
+    for (quint32 i = 1; i < threadCount; ++i)
+        threads.emplace_back(work);
+
+    work();
+
+    for (auto & thread : threads)
+        thread.join();
+
+    QByteArray payload;
+    QDataStream dataStream(&payload, QIODevice::WriteOnly);
+    dataStream.setByteOrder(QDataStream::LittleEndian);
+
+    dataStream << static_cast<quint64>(size) << static_cast<quint32>(chunkSize) << chunkCount;
+
+    // chunks that do not shrink are stored as is, so that no chunk exceeds its size
+    for (quint32 i = 0; i < chunkCount; ++i)
+    {
+        const size_t length = std::min(chunkSize, size - i * chunkSize);
+
+        if (chunks[i].size() < length)
+            dataStream << static_cast<quint32>(chunks[i].size());
+        else
+            dataStream << (static_cast<quint32>(length) | glraw::lz4::s_uncompressedChunk);
+    }
+
+    for (quint32 i = 0; i < chunkCount; ++i)
+    {
+        const size_t length = std::min(chunkSize, size - i * chunkSize);
+
+        if (chunks[i].size() < length)
+            dataStream.writeRawData(chunks[i].data(), static_cast<int>(chunks[i].size()));
+        else
+            dataStream.writeRawData(data.constData() + i * chunkSize, static_cast<int>(length));
+    }
+
+    return payload;
+}
+
+}
 
 namespace glraw
 {
@@ -18,38 +393,190 @@ namespace glraw
 FileWriter::FileWriter(bool headerEnabled, bool suffixesEnabled)
 :   m_headerEnabled(headerEnabled)
 ,   m_suffixesEnabled(suffixesEnabled)
+,   m_checksumEnabled(true)
+,   m_headerVersion(1)
+,   m_dataAlignment(4096)
+,   m_compression(Compression::None)
+,   m_directWriteThreshold(0)
+,   m_standardOutput(false)
+,   m_framed(false)
+,   m_durability(Durability::None)
+,   m_groupSize(0)
+,   m_packSize(0)
 {
 }
 
 FileWriter::~FileWriter()
 {
+    closePack();
+    flush();
 }
 
 bool FileWriter::write(const QByteArray & imageData,
     const QString & sourcePath, AssetInformation & info)
 {
     QString target = targetFilePath(sourcePath, info);
-    QFile file(target);
 
-    if(!file.open(QIODevice::WriteOnly))
+    if (packing())
+        return appendToPack(imageData, QFileInfo(target).fileName(), info);
+
+    QFile file(m_standardOutput ? QString() : temporaryFilePath(target));
+
+    if (m_standardOutput)
+    {
+#ifdef _WIN32
+        _setmode(1, _O_BINARY);
+#endif
+        file.open(1, QIODevice::WriteOnly | QIODevice::Unbuffered, QFileDevice::DontCloseHandle);
+    }
+    else
+        file.open(QIODevice::WriteOnly | QIODevice::Unbuffered);
+
+    if (!file.isOpen())
     {
         qDebug() << "Opening file" << target << "failed.";
         return false;
     }
 
-    QDataStream dataStream(&file);
+    const QByteArray payloadData = payload(imageData, info);
+    const QByteArray headerData = m_headerEnabled ? header(info, imageData) : QByteArray();
+    const QByteArray frameData = m_framed ? frame(headerData.size() + payloadData.size()) : QByteArray();
+
+    const bool direct = !m_standardOutput && m_directWriteThreshold > 0
+        && payloadData.size() >= m_directWriteThreshold && enableDirectWriting(file);
 
-    if (m_headerEnabled)
+    if (!(direct ? writeDirect(file, { frameData, headerData, payloadData })
+        : writeAll(file, { frameData, headerData, payloadData })))
     {
-        dataStream.setByteOrder(QDataStream::LittleEndian);
-        writeHeader(dataStream, file, info);
-    }
+        qDebug() << "Writing file" << target << "failed.";
 
-    dataStream.writeRawData(imageData.data(), imageData.size());
+        if (!m_standardOutput)
+            file.remove();
 
-    file.close();
+        return false;
+    }
+
+    if (!m_standardOutput && !commit(file, target))
+        return false;
     
-    qDebug() << qPrintable(QFileInfo(target).fileName()) << "created.";
+    qDebug() << qPrintable(QFileInfo(target).fileName()) << (m_standardOutput ? "written." : "created.");
+    return true;
+}
+
+bool FileWriter::isUpToDate(const QString & sourcePath, const AssetInformation & info) const
+{
+    // packs and pipes are rewritten as a whole, headerless files lack the properties
+    if (packing() || m_standardOutput || !m_headerEnabled)
+        return false;
+
+    const QFileInfo fileInfo(sourcePath);
+    const QDir directory(outputPathSet() ? m_outputPath : fileInfo.absolutePath());
+
+    // base names end at the first dot, so that suffixes of other sources cannot match
+    const QString filter = fileInfo.baseName() + (m_suffixesEnabled ? ".*.glraw" : ".glraw");
+
+    for (const QString & fileName : directory.entryList(QStringList() << filter, QDir::Files))
+    {
+        const RawFile file(QFile::encodeName(directory.filePath(fileName)).toStdString()
+            , true, RawFile::Access::HeaderOnly);
+
+        if (!file.isValid())
+            continue;
+
+        bool matches = true;
+        QMapIterator<QVariantMap::key_type, QVariantMap::mapped_type> iterator(info.properties());
+
+        while (matches && iterator.hasNext())
+        {
+            iterator.next();
+
+            const std::string key = iterator.key().toStdString();
+            const QVariant & value = iterator.value();
+
+            switch (propertyType(value.type()))
+            {
+            case RawFile::PropertyType::Int:
+                matches = file.hasIntProperty(key) && file.intProperty(key) == value.toInt();
+                break;
+
+            case RawFile::PropertyType::Double:
+                matches = file.hasDoubleProperty(key) && file.doubleProperty(key) == value.toDouble();
+                break;
+
+            case RawFile::PropertyType::String:
+                matches = file.hasStringProperty(key) && file.stringProperty(key) == value.toString().toStdString();
+                break;
+
+            default:
+                break;
+            }
+        }
+
+        if (matches)
+            return true;
+    }
+
+    return false;
+}
+
+bool FileWriter::writeDuplicate(const QString & sourcePath,
+    const QString & originalSourcePath, const AssetInformation & info)
+{
+    const QString target = targetFilePath(sourcePath, info);
+    const QString original = targetFilePath(originalSourcePath, info);
+
+    if (packing())
+    {
+        const QByteArray originalName = QFileInfo(original).fileName().toUtf8();
+
+        for (int i = m_packEntries.size() - 1; i >= 0; --i)
+        {
+            if (m_packEntries[i].name != originalName)
+                continue;
+
+            m_packEntries.append({ QFileInfo(target).fileName().toUtf8(), m_packEntries[i].offset, m_packEntries[i].size });
+
+            qDebug() << qPrintable(QFileInfo(target).fileName()) << "packed as duplicate.";
+            return true;
+        }
+
+        return false;
+    }
+
+    if (m_standardOutput)
+        return false;
+
+    // equal base names of sources in one directory yield one output anyway
+    if (target == original)
+        return true;
+
+    // the original may still await its rename within the current group
+    QString originalPath = original;
+
+    for (const PendingFile & file : m_pendingFiles)
+    {
+        if (file.targetPath == original)
+            originalPath = file.temporaryPath;
+    }
+
+    // linked next to the target and renamed like written files, replacing it atomically
+    QFile file(temporaryFilePath(target));
+    file.remove();
+
+    if (!linkFile(originalPath, file.fileName()))
+    {
+        qDebug() << "Linking" << target << "to" << original << "failed.";
+        return false;
+    }
+
+    // opened for writing, since Windows requires write access for syncing
+    if (!file.open(QIODevice::ReadWrite) || !commit(file, target))
+    {
+        file.remove();
+        return false;
+    }
+
+    qDebug() << qPrintable(QFileInfo(target).fileName()) << "linked.";
     return true;
 }
 
@@ -73,6 +600,207 @@ void FileWriter::setSuffixesEnabled(bool b)
     m_suffixesEnabled = b;
 }
 
+bool FileWriter::checksumEnabled() const
+{
+    return m_checksumEnabled;
+}
+
+void FileWriter::setChecksumEnabled(bool b)
+{
+    m_checksumEnabled = b;
+}
+
+int FileWriter::headerVersion() const
+{
+    return m_headerVersion;
+}
+
+void FileWriter::setHeaderVersion(int version)
+{
+    m_headerVersion = version;
+}
+
+int FileWriter::dataAlignment() const
+{
+    return m_dataAlignment;
+}
+
+void FileWriter::setDataAlignment(int alignment)
+{
+    m_dataAlignment = alignment;
+}
+
+FileWriter::Compression FileWriter::compression() const
+{
+    return m_compression;
+}
+
+void FileWriter::setCompression(Compression compression)
+{
+    m_compression = compression;
+}
+
+qint64 FileWriter::directWriteThreshold() const
+{
+    return m_directWriteThreshold;
+}
+
+void FileWriter::setDirectWriteThreshold(qint64 bytes)
+{
+    m_directWriteThreshold = bytes;
+}
+
+bool FileWriter::standardOutput() const
+{
+    return m_standardOutput;
+}
+
+void FileWriter::setStandardOutput(bool b)
+{
+    m_standardOutput = b;
+}
+
+bool FileWriter::framed() const
+{
+    return m_framed;
+}
+
+void FileWriter::setFramed(bool b)
+{
+    m_framed = b;
+}
+
+bool FileWriter::writeEmptyFrame()
+{
+    QFile file;
+    file.open(1, QIODevice::WriteOnly | QIODevice::Unbuffered, QFileDevice::DontCloseHandle);
+
+    return writeAll(file, { frame(0) });
+}
+
+QByteArray FileWriter::payload(const QByteArray & imageData, AssetInformation & info) const
+{
+    // compressed formats hardly shrink any further
+    if (m_compression == Compression::None || !m_headerEnabled
+        || info.propertyExists("compressedFormat") || imageData.isEmpty())
+        return imageData;
+
+    const QByteArray compressed = compressChunks(imageData);
+
+    if (compressed.size() >= imageData.size())
+        return imageData;
+
+    info.setProperty("compression", QString("lz4"));
+
+    return compressed;
+}
+
+QByteArray FileWriter::frame(quint64 size)
+{
+    QByteArray frame;
+    QDataStream dataStream(&frame, QIODevice::WriteOnly);
+    dataStream.setByteOrder(QDataStream::LittleEndian);
+    dataStream << size;
+
+    return frame;
+}
+
+FileWriter::Durability FileWriter::durability() const
+{
+    return m_durability;
+}
+
+void FileWriter::setDurability(Durability durability)
+{
+    m_durability = durability;
+}
+
+int FileWriter::groupSize() const
+{
+    return m_groupSize;
+}
+
+void FileWriter::setGroupSize(int size)
+{
+    m_groupSize = size;
+}
+
+bool FileWriter::flush()
+{
+    if (m_pendingFiles.isEmpty())
+        return true;
+
+    QStringList temporaryPaths;
+    for (const PendingFile & file : m_pendingFiles)
+        temporaryPaths << file.temporaryPath;
+
+    bool success = syncPaths(temporaryPaths);
+
+    if (!success)
+        qDebug() << "Syncing" << temporaryPaths.size() << "files failed.";
+
+    QSet<QString> directories;
+
+    for (const PendingFile & file : m_pendingFiles)
+    {
+        // files that were not synced are not renamed, so that no partial file replaces a valid one
+        if (success && replaceFile(file.temporaryPath, file.targetPath))
+        {
+            directories.insert(QFileInfo(file.targetPath).absolutePath());
+            continue;
+        }
+
+        if (success)
+            qDebug() << "Renaming" << file.temporaryPath << "failed.";
+
+        QFile::remove(file.temporaryPath);
+        success = false;
+    }
+
+    // renames are durable only once their directories are synced
+    for (const QString & directory : directories)
+        success = syncDirectory(directory) && success;
+
+    m_pendingFiles.clear();
+
+    return success;
+}
+
+bool FileWriter::commit(QFile & file, const QString & target)
+{
+    if (m_durability == Durability::Group)
+    {
+        file.close();
+        m_pendingFiles.append({ file.fileName(), target });
+
+        if (m_groupSize > 0 && m_pendingFiles.size() >= m_groupSize)
+            return flush();
+
+        return true;
+    }
+
+    if (m_durability == Durability::File && !syncFile(file))
+    {
+        qDebug() << "Syncing" << file.fileName() << "failed.";
+        file.remove();
+        return false;
+    }
+
+    file.close();
+
+    if (!replaceFile(file.fileName(), target))
+    {
+        qDebug() << "Renaming" << file.fileName() << "failed.";
+        file.remove();
+        return false;
+    }
+
+    if (m_durability == Durability::File)
+        return syncDirectory(QFileInfo(target).absolutePath());
+
+    return true;
+}
+
 bool FileWriter::outputPathSet() const
 {
     return !m_outputPath.isEmpty();
@@ -83,15 +811,15 @@ void FileWriter::setOutputPath(const QString & path)
     m_outputPath = path;
 }
 
-void FileWriter::writeHeader(QDataStream & dataStream, QFile & file, AssetInformation & info)
+QByteArray FileWriter::header(AssetInformation & info, const QByteArray & imageData) const
 {
     if (info.properties().empty())
-        return;
-
-    dataStream << static_cast<quint16>(RawFile::s_signature);
+        return QByteArray();
 
-    quint64 rawDataOffsetPosition = file.pos();
-    dataStream << static_cast<quint64>(0);
+    // the header is serialized in memory, so that no seeking is needed on the output
+    QByteArray properties;
+    QDataStream propertyStream(&properties, QIODevice::WriteOnly);
+    propertyStream.setByteOrder(QDataStream::LittleEndian);
 
     QMapIterator<QVariantMap::key_type, QVariantMap::mapped_type> iterator(info.properties());
 
@@ -107,17 +835,178 @@ void FileWriter::writeHeader(QDataStream & dataStream, QFile & file, AssetInform
         if (type == RawFile::PropertyType::Unknown)
             continue;
 
-        dataStream << static_cast<uint8_t>(type);
-        writeString(dataStream, key);
+        propertyStream << static_cast<uint8_t>(type);
+        writeString(propertyStream, key);
+
+        writeValue(propertyStream, value);
+    }
+
+    if (m_checksumEnabled)
+    {
+        const quint64 checksum = RawFile::checksum(imageData.data(), imageData.size());
+
+        propertyStream << static_cast<uint8_t>(RawFile::PropertyType::String);
+        writeString(propertyStream, "checksum");
+        writeString(propertyStream, QString::number(checksum, 16).rightJustified(16, '0'));
+    }
+
+    QByteArray header;
+    QDataStream dataStream(&header, QIODevice::WriteOnly);
+    dataStream.setByteOrder(QDataStream::LittleEndian);
+
+    if (m_headerVersion < 2)
+    {
+        const quint64 rawDataOffset = 10 + properties.size();
+
+        dataStream << static_cast<quint16>(RawFile::s_signature) << rawDataOffset;
+        dataStream.writeRawData(properties.constData(), properties.size());
+
+        return header;
+    }
+
+    // v2 extends the preamble to a fixed 32 bytes: a zero marker that ends the
+    // property parsing of v1 readers, the version, the property block size,
+    // the data alignment and reserved bytes
+    const quint32 alignment = static_cast<quint32>(qMax(1, m_dataAlignment));
+    const quint64 propertiesEnd = 32 + properties.size();
+
+    // zero padding, so that the raw data can be read with O_DIRECT or uploaded via DMA
+    const quint64 rawDataOffset = (propertiesEnd + alignment - 1) / alignment * alignment;
+
+    dataStream << static_cast<quint16>(RawFile::s_signature) << rawDataOffset;
+    dataStream << static_cast<quint8>(0) << static_cast<quint8>(2);
+    dataStream << static_cast<quint32>(properties.size()) << alignment;
+    dataStream << static_cast<quint32>(0) << static_cast<quint32>(0) << static_cast<quint32>(0);
+
+    dataStream.writeRawData(properties.constData(), properties.size());
+
+    header.append(QByteArray(static_cast<int>(rawDataOffset - propertiesEnd), '\0'));
+
+    return header;
+}
+
+bool FileWriter::openPack(const QString & path)
+{
+    closePack();
+
+    m_packPath = path;
+    m_pack.reset(new QFile(temporaryFilePath(path)));
 
-        writeValue(dataStream, value);
+    if (!m_pack->open(QIODevice::WriteOnly | QIODevice::Unbuffered))
+    {
+        qDebug() << "Opening file" << path << "failed.";
+        m_pack.reset();
+        return false;
+    }
+
+    // the preamble is written on closePack(), once the table of contents is known
+    m_pack->write(QByteArray(static_cast<int>(RawPack::s_preambleSize), '\0'));
+    m_packSize = RawPack::s_preambleSize;
+
+    return true;
+}
+
+bool FileWriter::closePack()
+{
+    if (!packing())
+        return true;
+
+    // the last of several entries of equal name wins
+    std::stable_sort(m_packEntries.begin(), m_packEntries.end(),
+        [](const PackEntry & a, const PackEntry & b) { return a.name < b.name; });
+
+    QVector<PackEntry> entries;
+    for (const PackEntry & entry : m_packEntries)
+    {
+        if (!entries.isEmpty() && entries.last().name == entry.name)
+        {
+            qWarning() << qPrintable(entry.name) << "is packed more than once.";
+            entries.last() = entry;
+        }
+        else
+            entries.append(entry);
     }
 
-    quint64 rawDataOffset = file.pos();
+    const quint64 tableOffset = (m_packSize + 7) / 8 * 8;
+    const QByteArray padding(static_cast<int>(tableOffset - m_packSize), '\0');
 
-    file.seek(rawDataOffsetPosition);
-    dataStream << rawDataOffset;
-    file.seek(rawDataOffset);
+    QByteArray table;
+    QDataStream tableStream(&table, QIODevice::WriteOnly);
+    tableStream.setByteOrder(QDataStream::LittleEndian);
+
+    quint64 nameOffset = tableOffset + entries.size() * RawPack::s_recordSize;
+
+    for (const PackEntry & entry : entries)
+    {
+        tableStream << nameOffset << static_cast<quint64>(entry.name.size()) << entry.offset << entry.size;
+        nameOffset += entry.name.size();
+    }
+
+    for (const PackEntry & entry : entries)
+        tableStream.writeRawData(entry.name.data(), entry.name.size());
+
+    QByteArray preamble;
+    QDataStream preambleStream(&preamble, QIODevice::WriteOnly);
+    preambleStream.setByteOrder(QDataStream::LittleEndian);
+
+    preambleStream << static_cast<quint16>(RawPack::s_signature) << static_cast<quint16>(RawPack::s_version)
+        << static_cast<quint32>(packAlignment()) << static_cast<quint64>(entries.size()) << tableOffset;
+
+    bool success = writeAll(*m_pack, { padding, table });
+    success = success && m_pack->seek(0) && m_pack->write(preamble) == preamble.size();
+
+    if (success)
+        success = commit(*m_pack, m_packPath);
+    else
+    {
+        qDebug() << "Writing" << m_packPath << "failed.";
+        m_pack->remove();
+    }
+
+    // packs are complete only once renamed, so they are not left to a later group
+    if (success && m_durability == Durability::Group)
+        success = flush();
+
+    if (success)
+        qDebug() << qPrintable(QFileInfo(m_packPath).fileName()) << "created," << entries.size() << "entries.";
+
+    m_pack.reset();
+    m_packEntries.clear();
+
+    return success;
+}
+
+bool FileWriter::packing() const
+{
+    return !m_pack.isNull();
+}
+
+bool FileWriter::appendToPack(const QByteArray & imageData, const QString & name, AssetInformation & info)
+{
+    const QByteArray payloadData = payload(imageData, info);
+    const QByteArray headerData = m_headerEnabled ? header(info, imageData) : QByteArray();
+
+    // entries start aligned, so that the aligned raw data of v2 headers stays aligned
+    const quint64 alignment = packAlignment();
+    const quint64 offset = (m_packSize + alignment - 1) / alignment * alignment;
+    const QByteArray padding(static_cast<int>(offset - m_packSize), '\0');
+
+    if (!writeAll(*m_pack, { padding, headerData, payloadData }))
+    {
+        qDebug() << "Writing" << m_pack->fileName() << "failed.";
+        return false;
+    }
+
+    m_packEntries.append({ name.toUtf8(), offset, static_cast<quint64>(headerData.size() + payloadData.size()) });
+    m_packSize = offset + m_packEntries.last().size;
+
+    qDebug() << qPrintable(name) << "packed.";
+    return true;
+}
+
+int FileWriter::packAlignment() const
+{
+    return m_headerVersion >= 2 ? qMax(8, m_dataAlignment) : 8;
 }
 
 RawFile::PropertyType FileWriter::propertyType(QVariant::Type type)
@@ -0,0 +1,257 @@
+
+#include <glraw/HDRImage.h>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <QDebug>
+#include <QFile>
+#include <QByteArray>
+#include <QList>
+
+
+namespace
+{
+
+bool hasSignature(const QByteArray & data)
+{
+    return data.startsWith("#?RADIANCE") || data.startsWith("#?RGBE");
+}
+
+QByteArray readLine(const uchar *& it, const uchar * end)
+{
+    const uchar * begin = it;
+
+    while (it < end && *it != '\n')
+        ++it;
+
+    QByteArray line(reinterpret_cast<const char *>(begin), static_cast<int>(it - begin));
+
+    if (it < end)
+        ++it;
+
+    return line;
+}
+
+// reads one scanline of RGBE pixels, either flat or adaptive run length encoded
+bool readScanline(const uchar *& it, const uchar * end, int width, uchar * rgbe)
+{
+    const bool encoded = width >= 8 && width < 0x8000 && end - it >= 4
+        && it[0] == 2 && it[1] == 2 && !(it[2] & 0x80);
+
+    if (!encoded)
+    {
+        if (end - it < width * 4)
+            return false;
+
+        std::memcpy(rgbe, it, width * 4);
+        it += width * 4;
+        return true;
+    }
+
+    if (((it[2] << 8) | it[3]) != width)
+        return false;
+
+    it += 4;
+
+    // each component is encoded separately
+    for (int component = 0; component < 4; ++component)
+    {
+        int x = 0;
+
+        while (x < width)
+        {
+            if (it >= end)
+                return false;
+
+            int count = *it++;
+
+            if (count > 128)
+            {
+                count -= 128;
+                if (count > width - x || it >= end)
+                    return false;
+
+                const uchar value = *it++;
+                for (; count > 0; --count)
+                    rgbe[(x++) * 4 + component] = value;
+            }
+            else
+            {
+                if (count == 0 || count > width - x || end - it < count)
+                    return false;
+
+                for (; count > 0; --count)
+                    rgbe[(x++) * 4 + component] = *it++;
+            }
+        }
+    }
+
+    return true;
+}
+
+// lower bound of the encoded size of one scanline, which caps the size that input data can claim
+qint64 minimumScanlineSize(int width)
+{
+    if (width < 8)
+        return static_cast<qint64>(width) * 4;
+
+    // header and one run of at most 127 pixels per component
+    return 4 + 4 * 2 * ((static_cast<qint64>(width) + 126) / 127);
+}
+
+} // namespace
+
+
+namespace glraw
+{
+
+HDRImage::HDRImage()
+:   m_width(0)
+,   m_height(0)
+{
+}
+
+HDRImage::HDRImage(const QString & fileName)
+:   m_width(0)
+,   m_height(0)
+{
+    load(fileName);
+}
+
+HDRImage::~HDRImage()
+{
+}
+
+bool HDRImage::canRead(const QString & fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    return hasSignature(file.read(10));
+}
+
+bool HDRImage::canReadData(const QByteArray & data)
+{
+    return hasSignature(data);
+}
+
+bool HDRImage::load(const QString & fileName)
+{
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Opening file" << fileName << "failed.";
+        return false;
+    }
+
+    return loadFromData(file.readAll());
+}
+
+bool HDRImage::loadFromData(const QByteArray & content)
+{
+    m_width = 0;
+    m_height = 0;
+    m_pixels.clear();
+
+    if (!hasSignature(content))
+    {
+        qDebug() << "Data is not a Radiance image.";
+        return false;
+    }
+
+    const uchar * it = reinterpret_cast<const uchar *>(content.constData());
+    const uchar * end = it + content.size();
+
+    // header lines are terminated by an empty line
+    for (QByteArray line = readLine(it, end); !line.isEmpty(); line = readLine(it, end))
+    {
+        if (line.startsWith("FORMAT=") && line != "FORMAT=32-bit_rle_rgbe")
+        {
+            qDebug() << "Radiance format" << line.mid(7) << "is not supported.";
+            return false;
+        }
+    }
+
+    // only the common orientations (-Y or +Y, +X) are supported
+    const QList<QByteArray> resolution = readLine(it, end).split(' ');
+
+    if (resolution.size() != 4 || resolution[2] != "+X"
+        || (resolution[0] != "-Y" && resolution[0] != "+Y"))
+    {
+        qDebug() << "Radiance resolution" << resolution.join(' ') << "is not supported.";
+        return false;
+    }
+
+    bool ok[2];
+    const int height = resolution[1].toInt(&ok[0]);
+    const int width = resolution[3].toInt(&ok[1]);
+
+    // sizes are checked before allocating, so that corrupt headers cannot claim arbitrary memory
+    if (!ok[0] || !ok[1] || width <= 0 || height <= 0
+        || static_cast<qint64>(width) * height * 4 > std::numeric_limits<int>::max()
+        || minimumScanlineSize(width) * height > end - it)
+    {
+        qDebug() << "Radiance resolution" << resolution.join(' ') << "is invalid.";
+        return false;
+    }
+
+    const bool topDown = resolution[0] == "-Y";
+
+    QVector<float> pixels(width * height * 4);
+    QVector<uchar> rgbe(width * 4);
+
+    for (int y = 0; y < height; ++y)
+    {
+        if (!readScanline(it, end, width, rgbe.data()))
+        {
+            qDebug() << "Reading Radiance pixel data failed.";
+            return false;
+        }
+
+        float * row = pixels.data() + (topDown ? height - 1 - y : y) * width * 4;
+
+        for (int x = 0; x < width; ++x)
+        {
+            const uchar * texel = rgbe.constData() + x * 4;
+            const float scale = texel[3] ? std::ldexp(1.f, texel[3] - (128 + 8)) : 0.f;
+
+            row[x * 4 + 0] = texel[0] * scale;
+            row[x * 4 + 1] = texel[1] * scale;
+            row[x * 4 + 2] = texel[2] * scale;
+            row[x * 4 + 3] = 1.f;
+        }
+    }
+
+    m_width = width;
+    m_height = height;
+    m_pixels.swap(pixels);
+
+    return true;
+}
+
+bool HDRImage::isNull() const
+{
+    return m_pixels.isEmpty();
+}
+
+int HDRImage::width() const
+{
+    return m_width;
+}
+
+int HDRImage::height() const
+{
+    return m_height;
+}
+
+const float * HDRImage::bits() const
+{
+    return m_pixels.constData();
+}
+
+} // namespace glraw
@@ -0,0 +1,151 @@
+
+#include <glraw/RawFileLoader.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <exception>
+
+
+namespace
+{
+
+std::shared_ptr<glraw::RawFile> loadFile(
+    const std::string & filePath,
+    bool parseProperties,
+    glraw::RawFile::Access access)
+{
+    // RawFile does not throw, but allocating it may; either way the request completes
+    try
+    {
+        std::shared_ptr<glraw::RawFile> file = std::make_shared<glraw::RawFile>(filePath, parseProperties, access);
+
+        if (!file->isValid())
+            return nullptr;
+
+        return file;
+    }
+    catch (const std::exception & exception)
+    {
+        fprintf(stderr, "Error: Loading %s failed: %s\n", filePath.c_str(), exception.what());
+        return nullptr;
+    }
+}
+
+}
+
+namespace glraw
+{
+
+RawFileLoader::RawFileLoader(int threadCount, size_t queueDepth)
+:   m_queueDepth(std::max<size_t>(1, queueDepth))
+,   m_pending(0)
+,   m_stopped(false)
+{
+    if (threadCount <= 0)
+        threadCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+
+    for (int i = 0; i < threadCount; ++i)
+        m_threads.emplace_back(&RawFileLoader::work, this);
+}
+
+RawFileLoader::~RawFileLoader()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_taskQueued.notify_all();
+
+    for (auto & thread : m_threads)
+        thread.join();
+}
+
+int RawFileLoader::threadCount() const
+{
+    return static_cast<int>(m_threads.size());
+}
+
+size_t RawFileLoader::queueDepth() const
+{
+    return m_queueDepth;
+}
+
+std::future<std::shared_ptr<RawFile>> RawFileLoader::load(
+    const std::string & filePath,
+    bool parseProperties,
+    RawFile::Access access)
+{
+    // std::function requires a copyable target, hence the shared promise
+    auto promise = std::make_shared<std::promise<std::shared_ptr<RawFile>>>();
+    std::future<std::shared_ptr<RawFile>> future = promise->get_future();
+
+    enqueue([promise, filePath, parseProperties, access]()
+    {
+        promise->set_value(loadFile(filePath, parseProperties, access));
+    });
+
+    return future;
+}
+
+void RawFileLoader::load(
+    const std::vector<std::string> & filePaths,
+    const Callback & callback,
+    bool parseProperties,
+    RawFile::Access access)
+{
+    for (const std::string & filePath : filePaths)
+    {
+        enqueue([callback, filePath, parseProperties, access]()
+        {
+            callback(filePath, loadFile(filePath, parseProperties, access));
+        });
+    }
+}
+
+void RawFileLoader::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_pending == 0; });
+}
+
+void RawFileLoader::enqueue(std::function<void()> && task)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_taskTaken.wait(lock, [this]() { return m_tasks.size() < m_queueDepth; });
+
+        m_tasks.push_back(std::move(task));
+        ++m_pending;
+    }
+    m_taskQueued.notify_one();
+}
+
+void RawFileLoader::work()
+{
+    for (;;)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskQueued.wait(lock, [this]() { return !m_tasks.empty() || m_stopped; });
+
+            // queued requests are completed before the workers stop
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        m_taskTaken.notify_one();
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_pending;
+        }
+        m_idle.notify_all();
+    }
+}
+
+} // namespace glraw
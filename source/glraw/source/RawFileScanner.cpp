@@ -0,0 +1,140 @@
+
+#include <glraw/RawFileScanner.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <QDirIterator>
+#include <QFile>
+#include <QThread>
+
+
+namespace
+{
+
+// bounds the paths buffered ahead of the workers
+const size_t s_maxQueuedPaths = 4096;
+
+}
+
+namespace glraw
+{
+
+RawFileScanner::RawFileScanner()
+:   m_threadCount(0)
+,   m_recursive(true)
+,   m_access(RawFile::Access::HeaderOnly)
+{
+}
+
+RawFileScanner::~RawFileScanner()
+{
+}
+
+int RawFileScanner::threadCount() const
+{
+    return m_threadCount;
+}
+
+void RawFileScanner::setThreadCount(int count)
+{
+    m_threadCount = count;
+}
+
+bool RawFileScanner::recursive() const
+{
+    return m_recursive;
+}
+
+void RawFileScanner::setRecursive(bool b)
+{
+    m_recursive = b;
+}
+
+RawFile::Access RawFileScanner::access() const
+{
+    return m_access;
+}
+
+void RawFileScanner::setAccess(RawFile::Access access)
+{
+    m_access = access;
+}
+
+int RawFileScanner::scan(const QString & directory, const Callback & callback) const
+{
+    std::mutex mutex;
+    std::condition_variable pathQueued;
+    std::condition_variable pathTaken;
+    std::deque<std::string> paths;
+    bool enumerated = false;
+
+    std::atomic<int> count(0);
+
+    auto probe = [&]()
+    {
+        for (;;)
+        {
+            std::string path;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                pathQueued.wait(lock, [&]() { return !paths.empty() || enumerated; });
+
+                if (paths.empty())
+                    return;
+
+                path = std::move(paths.front());
+                paths.pop_front();
+            }
+            pathTaken.notify_one();
+
+            // corrupt files are passed as invalid files, RawFile does not throw
+            const RawFile file(path, true, m_access);
+
+            callback(file);
+            ++count;
+        }
+    };
+
+    const int threadCount = m_threadCount > 0 ? m_threadCount : std::max(1, QThread::idealThreadCount());
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadCount; ++i)
+        threads.emplace_back(probe);
+
+    // directories are enumerated while the workers probe
+    QDirIterator iterator(directory, QStringList() << "*.glraw", QDir::Files
+        , m_recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+
+    while (iterator.hasNext())
+    {
+        std::string path = QFile::encodeName(iterator.next()).toStdString();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        pathTaken.wait(lock, [&]() { return paths.size() < s_maxQueuedPaths; });
+
+        paths.push_back(std::move(path));
+        lock.unlock();
+
+        pathQueued.notify_one();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        enumerated = true;
+    }
+    pathQueued.notify_all();
+
+    for (auto & thread : threads)
+        thread.join();
+
+    return count;
+}
+
+} // namespace glraw
@@ -0,0 +1,97 @@
+
+#include <glraw/WriteQueue.h>
+
+
+namespace glraw
+{
+
+WriteQueue::WriteQueue(size_t byteBudget)
+:   m_byteBudget(byteBudget)
+,   m_bytesInFlight(0)
+,   m_pending(0)
+,   m_failures(0)
+,   m_stopped(false)
+,   m_thread(&WriteQueue::work, this)
+{
+}
+
+WriteQueue::~WriteQueue()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_taskQueued.notify_one();
+
+    m_thread.join();
+}
+
+size_t WriteQueue::byteBudget() const
+{
+    return m_byteBudget;
+}
+
+void WriteQueue::enqueue(size_t size, Write && write)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+
+        // an idle queue admits any write, otherwise oversized writes would block forever
+        m_taskCompleted.wait(lock, [this, size]()
+        {
+            return m_pending == 0 || m_bytesInFlight + size <= m_byteBudget;
+        });
+
+        m_tasks.push_back({ size, std::move(write) });
+        m_bytesInFlight += size;
+        ++m_pending;
+    }
+    m_taskQueued.notify_one();
+}
+
+int WriteQueue::wait()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_taskCompleted.wait(lock, [this]() { return m_pending == 0; });
+
+    const int failures = m_failures;
+    m_failures = 0;
+
+    return failures;
+}
+
+void WriteQueue::work()
+{
+    for (;;)
+    {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_taskQueued.wait(lock, [this]() { return !m_tasks.empty() || m_stopped; });
+
+            // queued writes are completed before the thread stops
+            if (m_tasks.empty())
+                return;
+
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+
+        const bool written = task.write();
+
+        // release the data before admitting more
+        task.write = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bytesInFlight -= task.size;
+            --m_pending;
+
+            if (!written)
+                ++m_failures;
+        }
+        m_taskCompleted.notify_all();
+    }
+}
+
+} // namespace glraw